@@ -13,116 +13,252 @@
 
 static AudioEditor *g_editor = NULL;
 
+/* start_pos e duration dos clipes, e current_position, estão em 1/100000 s. */
+#define TIMELINE_UNITS_PER_SECOND 100000.0
+
+/* Cada movimento do mouse com o botão apertado toca um grão deste tamanho. */
+#define SCRUB_GRAIN_SECONDS 0.06
+
+/* Largura da faixa redesenhada em volta do cursor (a linha mais grossa tem 4 px). */
+#define CURSOR_STRIP_WIDTH 8
+
+/* Altura de cada faixa (TRACK_COUNT faixas, uma embaixo da outra). */
+#define TRACK_HEIGHT 90
+
+/*
+ * Zoom em pixels por segundo: do projeto inteiro (horas na tela) até várias
+ * dezenas de pixels por amostra. Cada passo da roda multiplica por ZOOM_STEP.
+ */
+#define ZOOM_DEFAULT 80.0f
+#define ZOOM_MIN 0.05
+#define ZOOM_MAX 1000000.0
+#define ZOOM_STEP 1.25
+
+/* Quanto a roda (ou um passo da barra) anda na horizontal. */
+#define SCROLL_STEP_PIXELS 50
+
+/*
+ * Clipes que guardam o desenho entre exposes (mais que os que cabem nas
+ * TRACK_COUNT faixas de uma tela). Cada um ocupa até duas telas de largura
+ * por uma faixa, mas só o tanto que o clipe tem de largura.
+ */
+#define CLIP_SURFACE_CACHE_MAX 256
+
+/*
+ * Duração da linha do tempo (no mínimo 10 s), o alcance da barra de rolagem.
+ * Guardada por update_clip_layout().
+ */
+static int64_t timeline_duration(AudioEditor *editor) {
+    return editor->timeline_end;
+}
+
+/* Clipe na posição index da tabela, ou NULL se não há. */
+static AudioClip *clip_at(AudioEditor *editor, int index) {
+    if (index < 0 || index >= editor->audio_clips.count) return NULL;
+    return editor->audio_clips.items[index];
+}
+
+/*
+ * Acrescenta o clipe no fim da tabela, com volume 1, pan 0 e sem mudo nem
+ * solo. Todos os vetores crescem juntos, dobrando a capacidade.
+ */
+static void clip_table_append(ClipTable *table, AudioClip *clip, int track, int64_t start_pos, int64_t duration) {
+    if (table->count == table->capacity) {
+        table->capacity = table->capacity ? table->capacity * 2 : 16;
+        table->start_pos = g_renew(int64_t, table->start_pos, table->capacity);
+        table->duration = g_renew(int64_t, table->duration, table->capacity);
+        table->volume = g_renew(float, table->volume, table->capacity);
+        table->pan = g_renew(float, table->pan, table->capacity);
+        table->muted = g_renew(uint8_t, table->muted, table->capacity);
+        table->solo = g_renew(uint8_t, table->solo, table->capacity);
+        table->track = g_renew(int, table->track, table->capacity);
+        table->items = g_renew(AudioClip *, table->items, table->capacity);
+    }
+    
+    int index = table->count++;
+    table->start_pos[index] = start_pos;
+    table->duration[index] = duration;
+    table->volume[index] = 1.0f;
+    table->pan[index] = 0.0f;
+    table->muted[index] = 0;
+    table->solo[index] = 0;
+    table->track[index] = track;
+    table->items[index] = clip;
+    clip->index = index;
+}
+
+/* Tira o clipe index da tabela; os seguintes andam uma posição para trás. */
+static void clip_table_remove(ClipTable *table, int index) {
+    size_t after = (size_t)(table->count - index - 1);
+    memmove(table->start_pos + index, table->start_pos + index + 1, after * sizeof(*table->start_pos));
+    memmove(table->duration + index, table->duration + index + 1, after * sizeof(*table->duration));
+    memmove(table->volume + index, table->volume + index + 1, after * sizeof(*table->volume));
+    memmove(table->pan + index, table->pan + index + 1, after * sizeof(*table->pan));
+    memmove(table->muted + index, table->muted + index + 1, after * sizeof(*table->muted));
+    memmove(table->solo + index, table->solo + index + 1, after * sizeof(*table->solo));
+    memmove(table->track + index, table->track + index + 1, after * sizeof(*table->track));
+    memmove(table->items + index, table->items + index + 1, after * sizeof(*table->items));
+    table->count--;
+    
+    for (int i = index; i < table->count; i++) {
+        table->items[i]->index = i;
+    }
+}
+
+static void clip_table_free(ClipTable *table) {
+    g_free(table->start_pos);
+    g_free(table->duration);
+    g_free(table->volume);
+    g_free(table->pan);
+    g_free(table->muted);
+    g_free(table->solo);
+    g_free(table->track);
+    g_free(table->items);
+    memset(table, 0, sizeof(*table));
+}
+
+/*
+ * Monta a lista de clipes para mix_clips() com posição, ganho, mudo e solo,
+ * lidos dos vetores da tabela. O clipe toca o arquivo inteiro
+ * (length_seconds = 0).
+ */
+static MixClip *collect_mix_clips(AudioEditor *editor, int *clip_count) {
+    const ClipTable *table = &editor->audio_clips;
+    *clip_count = table->count;
+    MixClip *clips = calloc(*clip_count, sizeof(MixClip));
+    if (!clips) return NULL;
+    
+    for (int i = 0; i < *clip_count; i++) {
+        clips[i].filename = table->items[i]->filename;
+        clips[i].volume = table->volume[i];
+        clips[i].pan = table->pan[i];
+        clips[i].start_seconds = table->start_pos[i] / TIMELINE_UNITS_PER_SECOND;
+        clips[i].length_seconds = 0;
+        clips[i].muted = table->muted[i];
+        clips[i].solo = table->solo[i];
+    }
+    return clips;
+}
+
+/* Descarta o desenho guardado do clipe; ele é refeito no próximo expose. */
+static void free_clip_surfaces(AudioEditor *editor, AudioClip *clip) {
+    ClipSurfaces *surfaces = &clip->surfaces;
+    if (surfaces->body) {
+        cairo_surface_destroy(surfaces->body);
+        surfaces->body = NULL;
+    }
+    if (surfaces->label) {
+        cairo_surface_destroy(surfaces->label);
+        surfaces->label = NULL;
+    }
+    if (surfaces->lru_link) {
+        g_queue_unlink(&editor->clip_surfaces, surfaces->lru_link);
+        g_list_free_1(surfaces->lru_link);
+        surfaces->lru_link = NULL;
+    }
+}
+
+/* Se a waveform ainda está sendo calculada, o cálculo é cancelado antes. */
+static void free_audio_clip(AudioEditor *editor, AudioClip *clip) {
+    free_clip_surfaces(editor, clip);
+    if (clip->peaks) {
+        peak_builder_remove(editor->peak_builder, clip->peaks);
+    }
+    if (clip->spectrogram) {
+        spectrogram_engine_remove(editor->spectrogram_engine, clip->spectrogram);
+    }
+    if (clip->reader) {
+        wav_reader_close(clip->reader);
+        g_free(clip->reader);
+    }
+    g_free(clip->filename);
+    g_free(clip);
+}
+
+static gboolean redraw_peaks_idle(gpointer user_data) {
+    AudioEditor *editor = (AudioEditor *)user_data;
+    atomic_store(&editor->peaks_redraw_pending, 0);
+    if (editor->timeline_drawing_area) {
+        gtk_widget_queue_draw(editor->timeline_drawing_area);
+    }
+    return G_SOURCE_REMOVE;
+}
+
+/*
+ * Chamado pelas threads da waveform a cada bloco pronto (e pelas do
+ * espectrograma a cada ladrilho). Só agenda um redesenho na thread do GTK;
+ * vários blocos seguidos viram um redesenho só.
+ */
+static void on_peaks_progress(void *user) {
+    AudioEditor *editor = (AudioEditor *)user;
+    if (!atomic_exchange(&editor->peaks_redraw_pending, 1)) {
+        g_idle_add(redraw_peaks_idle, editor);
+    }
+}
+
 #ifdef USE_SDL2
+/* Só copia o que a thread de reprodução já mixou; o que faltar vira silêncio. */
 static void audio_callback(void *userdata, Uint8 *stream, int len) {
     AudioEditor *editor = (AudioEditor *)userdata;
+    PlaybackEngine *playback = &editor->playback;
     
-    if (!editor || !editor->audio_playing || !editor->audio_buffer) {
-        memset(stream, 0, len);
-        return;
-    }
+    size_t frame_bytes = playback->channels * sizeof(int16_t);
+    size_t frames = frame_bytes > 0 ? len / frame_bytes : 0;
+    size_t copied = frames > 0 ? playback_engine_read(playback, (int16_t *)stream, frames) : 0;
     
-    int bytes_available = editor->audio_buffer_size - editor->audio_buffer_pos;
-    int bytes_to_copy = (bytes_available < len) ? bytes_available : len;
+    memset(stream + copied * frame_bytes, 0, len - copied * frame_bytes);
     
-    if (bytes_to_copy > 0) {
-        memcpy(stream, (Uint8 *)editor->audio_buffer + editor->audio_buffer_pos, bytes_to_copy);
-        editor->audio_buffer_pos += bytes_to_copy;
-        
-        if (editor->audio_buffer_size > 0) {
-            editor->current_position = (editor->audio_buffer_pos * 1000000) / editor->audio_buffer_size;
-        }
-    }
-    
-    if (bytes_to_copy < len) {
-        memset(stream + bytes_to_copy, 0, len - bytes_to_copy);
-        editor->audio_playing = 0;
-        editor->playing = 0;
-        editor->current_position = 0;
-    }
+    uint32_t generation;
+    atomic_store_explicit(&editor->clock_frame, playback_engine_position(playback, &generation), memory_order_relaxed);
+    atomic_store_explicit(&editor->clock_generation, generation, memory_order_relaxed);
+    atomic_store_explicit(&editor->clock_time, g_get_monotonic_time(), memory_order_release);
 }
 #endif
 
+/*
+ * Abre os clipes e começa a thread de reprodução a partir de current_position;
+ * só o primeiro pedaço é renderizado antes, então o som começa no primeiro
+ * período do dispositivo.
+ */
 static int load_audio_for_playback(AudioEditor *editor) {
     #ifndef USE_SDL2
     printf("⚠️ SDL2 não disponível. Reprodução de áudio desabilitada.\n");
     printf("💡 Instale SDL2 com: pacman -S mingw-w64-ucrt-x86_64-SDL2\n");
     return -1;
     #else
-    if (g_list_length(editor->audio_clips) == 0) {
+    if (editor->audio_clips.count == 0) {
         printf("❌ Nenhum áudio carregado para reproduzir\n");
         return -1;
     }
     
-    if (editor->audio_buffer) {
-        free(editor->audio_buffer);
-        editor->audio_buffer = NULL;
-    }
-    
-    #ifdef _WIN32
-    const char *temp_file = "playback_temp.wav";
-    #else
-    const char *temp_file = "/tmp/playback_temp.wav";
-    #endif
+    playback_engine_stop(&editor->playback);
     
-    int file_count = g_list_length(editor->audio_clips);
-    const char **input_files = malloc(file_count * sizeof(char*));
-    float *volumes = malloc(file_count * sizeof(float));
-    float *pans = malloc(file_count * sizeof(float));
+    int clip_count;
+    MixClip *clips = collect_mix_clips(editor, &clip_count);
+    if (!clips) return -1;
     
-    int i = 0;
-    GList *iter = editor->audio_clips;
-    while (iter != NULL) {
-        AudioClip *clip = (AudioClip *)iter->data;
-        input_files[i] = clip->filename;
-        volumes[i] = clip->volume;
-        pans[i] = clip->pan;
-        i++;
-        iter = g_list_next(iter);
+    MixStream *mix_stream = mix_stream_open(clips, clip_count, NULL);
+    free(clips);
+    uint64_t first_frame = 0;
+    if (mix_stream) {
+        first_frame = (uint64_t)llround(editor->current_position / TIMELINE_UNITS_PER_SECOND *
+                                        mix_stream_sample_rate(mix_stream));
     }
-    
-    if (mix_wav_files(temp_file, input_files, volumes, pans, file_count) != 0) {
+    if (!mix_stream || playback_engine_start(&editor->playback, mix_stream, first_frame) != 0) {
         printf("❌ Erro ao mixar arquivos para reprodução\n");
-        free(input_files);
-        free(volumes);
-        free(pans);
         return -1;
     }
+    atomic_store(&editor->clock_time, 0);
     
-    free(input_files);
-    free(volumes);
-    free(pans);
-    
-    #ifdef USE_SDL2
-    SDL_AudioSpec wav_spec;
-    Uint32 wav_length;
-    Uint8 *wav_buffer;
-    
-    if (SDL_LoadWAV(temp_file, &wav_spec, &wav_buffer, &wav_length) == NULL) {
-        printf("❌ Erro ao carregar WAV: %s\n", SDL_GetError());
-        return -1;
-    }
-    
-    editor->audio_spec = wav_spec;
+    SDL_zero(editor->audio_spec);
+    editor->audio_spec.freq = editor->playback.sample_rate;
+    editor->audio_spec.channels = editor->playback.channels;
     editor->audio_spec.format = AUDIO_S16SYS;
-    editor->audio_buffer = (int16_t *)wav_buffer;
-    editor->audio_buffer_size = wav_length;
-    editor->audio_buffer_pos = 0;
-    #else
-    FILE *f = fopen(temp_file, "rb");
-    if (f) {
-        fseek(f, 0, SEEK_END);
-        editor->audio_buffer_size = ftell(f);
-        fclose(f);
-        editor->audio_buffer_pos = 0;
-        printf("✅ Arquivo preparado: %zu bytes (reprodução desabilitada - SDL2 não disponível)\n", 
-               editor->audio_buffer_size);
-    }
-    #endif
+    editor->audio_spec.samples = 1024;
     
     return 0;
+    #endif
 }
-#endif
 
 static void on_open_file(GtkButton *button, gpointer user_data);
 static void on_play(GtkButton *button, gpointer user_data);
@@ -130,8 +266,56 @@ static void on_stop(GtkButton *button, gpointer user_data);
 static void on_export(GtkButton *button, gpointer user_data);
 static gboolean draw_timeline(GtkWidget *widget, cairo_t *cr, gpointer user_data);
 static gboolean on_timeline_button_press(GtkWidget *widget, GdkEventButton *event, gpointer user_data);
+static gboolean on_timeline_motion(GtkWidget *widget, GdkEventMotion *event, gpointer user_data);
+static gboolean on_timeline_button_release(GtkWidget *widget, GdkEventButton *event, gpointer user_data);
 static void update_mixer_controls(AudioEditor *editor);
 static void update_info_label(AudioEditor *editor);
+static void update_clip_layout(AudioEditor *editor);
+
+static void add_audio_clip(AudioEditor *editor, const char *filename) {
+    WAV_Info wav_info;
+    int64_t duration = 1000000;
+    if (get_wav_info(filename, &wav_info) == 0 && wav_info.sample_rate > 0) {
+        duration = llround(wav_info.duration_samples * TIMELINE_UNITS_PER_SECOND / wav_info.sample_rate);
+        printf("📊 WAV Info: %d Hz, %d canais, %d bits, %llu amostras\n", 
+               wav_info.sample_rate, wav_info.num_channels, 
+               wav_info.bits_per_sample, (unsigned long long)wav_info.duration_samples);
+    }
+    
+    AudioClip *clip = g_malloc0(sizeof(AudioClip));
+    clip->filename = g_strdup(filename);
+    /* A waveform é calculada em segundo plano e aparece aos poucos. */
+    clip->peaks = editor->peak_builder ? peak_builder_add(editor->peak_builder, filename) : NULL;
+    /* Mapear não lê nada: só as páginas desenhadas no zoom de perto são carregadas. */
+    if (clip->peaks) {
+        clip->reader = g_malloc0(sizeof(WavReader));
+        if (wav_reader_open(clip->reader, filename, WAV_READER_MAP) != 0) {
+            g_free(clip->reader);
+            clip->reader = NULL;
+        }
+    }
+    /* Só abre o arquivo: os ladrilhos são calculados quando aparecem na tela. */
+    clip->spectrogram = editor->spectrogram_engine ? spectrogram_engine_add(editor->spectrogram_engine, filename) : NULL;
+    
+    /* Entra na faixa que termina primeiro, logo depois do último clipe dela. */
+    int track = 0;
+    for (int i = 1; i < TRACK_COUNT; i++) {
+        if (editor->tracks[i].end < editor->tracks[track].end) track = i;
+    }
+    int64_t start_pos = editor->tracks[track].end;
+    editor->tracks[track].end = start_pos + duration;
+    
+    clip_table_append(&editor->audio_clips, clip, track, start_pos, duration);
+    
+    printf("✅ Arquivo adicionado: %s\n", filename);
+    
+    if (editor->status_bar) {
+        char status_msg[200];
+        snprintf(status_msg, sizeof(status_msg), "✅ Arquivo adicionado: %s", strrchr(filename, '/') ? strrchr(filename, '/') + 1 : (strrchr(filename, '\\') ? strrchr(filename, '\\') + 1 : filename));
+        gtk_statusbar_pop(GTK_STATUSBAR(editor->status_bar), 0);
+        gtk_statusbar_push(GTK_STATUSBAR(editor->status_bar), 0, status_msg);
+    }
+}
 
 static void on_open_file(GtkButton *button, gpointer user_data) {
     AudioEditor *editor = (AudioEditor *)user_data;
@@ -152,150 +336,321 @@ static void on_open_file(GtkButton *button, gpointer user_data) {
     gtk_file_filter_set_name(filter_all, "Todos os arquivos");
     gtk_file_filter_add_pattern(filter_all, "*");
     gtk_file_chooser_add_filter(GTK_FILE_CHOOSER(dialog), filter_all);
+    gtk_file_chooser_set_select_multiple(GTK_FILE_CHOOSER(dialog), TRUE);
     
     if (gtk_dialog_run(GTK_DIALOG(dialog)) == GTK_RESPONSE_ACCEPT) {
-        char *filename = gtk_file_chooser_get_filename(GTK_FILE_CHOOSER(dialog));
-        
-        WAV_Info wav_info;
-        int duration_samples = 100000;
-        if (get_wav_info(filename, &wav_info) == 0) {
-            duration_samples = wav_info.duration_samples;
-            printf("📊 WAV Info: %d Hz, %d canais, %d bits, %d amostras\n", 
-                   wav_info.sample_rate, wav_info.num_channels, 
-                   wav_info.bits_per_sample, wav_info.duration_samples);
-        }
-        
-        AudioClip *clip = g_malloc0(sizeof(AudioClip));
-        clip->filename = g_strdup(filename);
-        clip->volume = 1.0f;
-        clip->pan = 0.0f;
-        clip->start_pos = 0;
-        clip->duration = duration_samples * 10;
-        clip->muted = 0;
-        clip->solo = 0;
-        
-        editor->audio_clips = g_list_append(editor->audio_clips, clip);
-        
-        printf("✅ Arquivo adicionado: %s\n", filename);
-        
-        if (editor->status_bar) {
-            char status_msg[200];
-            snprintf(status_msg, sizeof(status_msg), "✅ Arquivo adicionado: %s", strrchr(filename, '/') ? strrchr(filename, '/') + 1 : (strrchr(filename, '\\') ? strrchr(filename, '\\') + 1 : filename));
-            gtk_statusbar_pop(GTK_STATUSBAR(editor->status_bar), 0);
-            gtk_statusbar_push(GTK_STATUSBAR(editor->status_bar), 0, status_msg);
+        GSList *filenames = gtk_file_chooser_get_filenames(GTK_FILE_CHOOSER(dialog));
+        for (GSList *file = filenames; file != NULL; file = file->next) {
+            add_audio_clip(editor, (const char *)file->data);
         }
+        g_slist_free_full(filenames, g_free);
         
         update_info_label(editor);
+        update_clip_layout(editor);
         
         if (editor->timeline_drawing_area) {
             gtk_widget_queue_draw(editor->timeline_drawing_area);
         }
-        
-        g_free(filename);
     }
     
     gtk_widget_destroy(dialog);
 }
 
-static gboolean update_playback(gpointer user_data) {
-    AudioEditor *editor = (AudioEditor *)user_data;
-    
-    if (!editor->playing || !editor->audio_playing) {
-        if (editor->audio_buffer_pos >= editor->audio_buffer_size) {
-            editor->playing = 0;
-            editor->audio_playing = 0;
-            editor->current_position = 0;
-            editor->audio_buffer_pos = 0;
-            #ifdef USE_SDL2
-            if (editor->audio_device != 0) {
-                SDL_PauseAudioDevice(editor->audio_device, 1);
-            }
-            #endif
-        }
-        return editor->playing ? TRUE : FALSE;
+/*
+ * Pausa o dispositivo antes de parar a thread de reprodução: depois da pausa o
+ * callback não roda mais, então o anel pode ser liberado.
+ */
+static void halt_playback(AudioEditor *editor) {
+    #ifdef USE_SDL2
+    if (editor->audio_device != 0) {
+        SDL_PauseAudioDevice(editor->audio_device, 1);
+    }
+    #endif
+    playback_engine_stop(&editor->playback);
+}
+
+static void stop_playback(AudioEditor *editor) {
+    editor->playing = 0;
+    editor->audio_playing = 0;
+    editor->scrubbing = 0;
+    editor->current_position = 0;
+    halt_playback(editor);
+}
+
+/*
+ * Quadro que o dispositivo está tocando no instante frame_time. O último
+ * callback entregou até clock_frame, e esse buffer (audio_spec.samples quadros)
+ * começou a tocar em clock_time; entre callbacks o cursor anda pelo relógio.
+ * Até o callback entregar algo do último seek, o cursor fica no destino dele.
+ */
+static uint64_t playhead_frame(AudioEditor *editor, gint64 frame_time) {
+    PlaybackEngine *playback = &editor->playback;
+    gint64 clock_time = atomic_load_explicit(&editor->clock_time, memory_order_acquire);
+    uint64_t clock_frame = atomic_load_explicit(&editor->clock_frame, memory_order_relaxed);
+    uint32_t clock_generation = atomic_load_explicit(&editor->clock_generation, memory_order_relaxed);
+    if (clock_time == 0 || clock_generation != playback->seek_generation || clock_frame < playback->seek_frame) {
+        return playback->seek_frame;
     }
     
-    int max_duration = 1000000;
+    uint64_t buffer_frames = 0;
     #ifdef USE_SDL2
-    if (editor->audio_buffer_size > 0 && editor->audio_spec.freq > 0) {
-        int samples = editor->audio_buffer_size / (sizeof(int16_t) * editor->audio_spec.channels);
-        int seconds = samples / editor->audio_spec.freq;
-        max_duration = seconds * 100000;
+    buffer_frames = editor->audio_spec.samples;
+    #endif
+    uint64_t start = clock_frame - playback->seek_frame > buffer_frames ? clock_frame - buffer_frames
+                                                                         : playback->seek_frame;
+    gint64 elapsed = frame_time > clock_time ? frame_time - clock_time : 0;
+    uint64_t frame = start + (uint64_t)(elapsed * (double)playback->sample_rate / G_USEC_PER_SEC);
+    return frame < clock_frame ? frame : clock_frame;
+}
+
+/* Coordenada x de um instante da linha do tempo, no zoom e na rolagem atuais. */
+static double timeline_x(AudioEditor *editor, double seconds) {
+    return (seconds - editor->view_start) * editor->zoom_level;
+}
+
+/* Segundos da linha do tempo sob a coordenada x. */
+static double timeline_seconds_at(AudioEditor *editor, double x) {
+    double seconds = editor->view_start + x / editor->zoom_level;
+    return seconds > 0 ? seconds : 0;
+}
+
+/* Coluna do cursor numa área de largura width, ou -1 se ele não aparece. */
+static int cursor_position_x(AudioEditor *editor, int width) {
+    if (!editor->playing && editor->current_position <= 0) return -1;
+    double x = timeline_x(editor, editor->current_position / TIMELINE_UNITS_PER_SECOND);
+    return x >= 0 && x < width ? (int)x : -1;
+}
+
+/*
+ * Ajusta a barra de rolagem ao zoom e à largura atuais: a página é o trecho
+ * visível, em segundos. A área de desenho tem só a largura da janela; a
+ * rolagem horizontal é nossa, porque em zoom de amostras a linha do tempo
+ * teria bilhões de pixels.
+ */
+static void update_timeline_scroll(AudioEditor *editor) {
+    if (!editor->timeline_hadjustment || !editor->timeline_drawing_area) return;
+    
+    int width = gtk_widget_get_allocated_width(editor->timeline_drawing_area);
+    if (width <= 0) return;
+    
+    double page = width / editor->zoom_level;
+    double upper = timeline_duration(editor) / TIMELINE_UNITS_PER_SECOND;
+    if (upper < editor->view_start + page) upper = editor->view_start + page;
+    gtk_adjustment_configure(editor->timeline_hadjustment, editor->view_start, 0, upper,
+                             SCROLL_STEP_PIXELS / editor->zoom_level, page * 0.9, page);
+}
+
+/* Rola a linha do tempo para começar em start_seconds (limitado pela barra). */
+static void set_view(AudioEditor *editor, double start_seconds) {
+    if (start_seconds < 0) start_seconds = 0;
+    if (editor->timeline_hadjustment) {
+        gtk_adjustment_set_value(editor->timeline_hadjustment, start_seconds);
+        start_seconds = gtk_adjustment_get_value(editor->timeline_hadjustment);
     }
-    #else
-    if (editor->audio_buffer_size > 0) {
-        int samples = editor->audio_buffer_size / (sizeof(int16_t) * 2);
-        int seconds = samples / 44100;
-        max_duration = seconds * 100000;
+    editor->view_start = start_seconds;
+    if (editor->timeline_drawing_area) {
+        gtk_widget_queue_draw(editor->timeline_drawing_area);
+    }
+}
+
+/* Multiplica o zoom por factor mantendo parado o instante sob anchor_x. */
+static void zoom_timeline(AudioEditor *editor, double factor, double anchor_x) {
+    double anchor_seconds = editor->view_start + anchor_x / editor->zoom_level;
+    double zoom = editor->zoom_level * factor;
+    if (zoom < ZOOM_MIN) zoom = ZOOM_MIN;
+    if (zoom > ZOOM_MAX) zoom = ZOOM_MAX;
+    
+    editor->zoom_level = (float)zoom;
+    editor->view_start = anchor_seconds - anchor_x / editor->zoom_level;
+    if (editor->view_start < 0) editor->view_start = 0;
+    update_timeline_scroll(editor);
+    if (editor->timeline_drawing_area) {
+        gtk_widget_queue_draw(editor->timeline_drawing_area);
+    }
+}
+
+static gint compare_clip_start(gconstpointer a, gconstpointer b, gpointer user_data) {
+    const int64_t *start_pos = (const int64_t *)user_data;
+    int64_t start_a = start_pos[*(const int *)a];
+    int64_t start_b = start_pos[*(const int *)b];
+    return start_a < start_b ? -1 : start_a > start_b;
+}
+
+/*
+ * Refaz a disposição depois que clipes entram, saem ou mudam de tamanho: o
+ * índice de intervalos de cada faixa e o fim da linha do tempo. O desenho e
+ * os cliques só consultam o resultado, sem percorrer a tabela.
+ */
+static void update_clip_layout(AudioEditor *editor) {
+    const ClipTable *table = &editor->audio_clips;
+    for (int track = 0; track < TRACK_COUNT; track++) {
+        editor->tracks[track].count = 0;
+        editor->tracks[track].end = 0;
     }
-    #endif
     
-    if (editor->audio_buffer_pos >= editor->audio_buffer_size) {
-        editor->playing = 0;
-        editor->audio_playing = 0;
-        editor->current_position = 0;
-        editor->audio_buffer_pos = 0;
-        #ifdef USE_SDL2
-        if (editor->audio_device != 0) {
-            SDL_PauseAudioDevice(editor->audio_device, 1);
+    editor->timeline_end = 1000000;
+    for (int i = 0; i < table->count; i++) {
+        ClipTrack *track = &editor->tracks[table->track[i]];
+        if (track->count == track->capacity) {
+            track->capacity = track->capacity ? track->capacity * 2 : 16;
+            track->clips = g_renew(int, track->clips, track->capacity);
+            track->max_end = g_renew(int64_t, track->max_end, track->capacity);
         }
-        #endif
-        if (editor->timeline_drawing_area) {
-            gtk_widget_queue_draw(editor->timeline_drawing_area);
+        track->clips[track->count++] = i;
+        
+        int64_t end = table->start_pos[i] + table->duration[i];
+        if (end > track->end) track->end = end;
+        if (end > editor->timeline_end) editor->timeline_end = end;
+    }
+    
+    for (int t = 0; t < TRACK_COUNT; t++) {
+        ClipTrack *track = &editor->tracks[t];
+        g_qsort_with_data(track->clips, track->count, sizeof(int), compare_clip_start, table->start_pos);
+        int64_t max_end = 0;
+        for (int i = 0; i < track->count; i++) {
+            int index = track->clips[i];
+            int64_t end = table->start_pos[index] + table->duration[index];
+            if (end > max_end) max_end = end;
+            track->max_end[i] = max_end;
         }
-        return FALSE;
     }
     
-    if (editor->timeline_drawing_area) {
-        gtk_widget_queue_draw(editor->timeline_drawing_area);
+    update_timeline_scroll(editor);
+}
+
+/*
+ * Primeiro clipe (posição em track->clips) que pode terminar depois de
+ * position: os anteriores acabam todos antes. A partir dele, os clipes que
+ * cobrem [position, end) são os que começam antes de end.
+ */
+static int track_first_clip(const ClipTrack *track, int64_t position) {
+    int low = 0, high = track->count;
+    while (low < high) {
+        int middle = low + (high - low) / 2;
+        if (track->max_end[middle] > position) {
+            high = middle;
+        } else {
+            low = middle + 1;
+        }
     }
+    return low;
+}
+
+/* Instante da linha do tempo sob a coordenada x, em 1/100000 s. */
+static int64_t timeline_position_at(AudioEditor *editor, double x) {
+    return llround(timeline_seconds_at(editor, x) * TIMELINE_UNITS_PER_SECOND);
+}
+
+/* Clipe sob o ponto (x, y) da área da linha do tempo, ou NULL. */
+static AudioClip *clip_at_point(AudioEditor *editor, double x, double y) {
+    if (y < 0 || y >= TRACK_COUNT * TRACK_HEIGHT) return NULL;
+    int t = (int)(y / TRACK_HEIGHT);
+    double track_y = t * TRACK_HEIGHT + 5;
+    if (y < track_y || y > track_y + TRACK_HEIGHT - 10) return NULL;
+    
+    /* Clipes que se sobrepõem: vale o de cima, desenhado por último. */
+    const ClipTable *table = &editor->audio_clips;
+    const ClipTrack *track = &editor->tracks[t];
+    int64_t position = timeline_position_at(editor, x);
+    AudioClip *found = NULL;
+    for (int i = track_first_clip(track, position); i < track->count; i++) {
+        int index = track->clips[i];
+        if (table->start_pos[index] > position) break;
+        if (table->start_pos[index] + table->duration[index] >= position) found = table->items[index];
+    }
+    return found;
+}
+
+/*
+ * Invalida só a faixa onde o cursor estava e a faixa para onde ele foi, em vez
+ * da linha do tempo inteira; nada é redesenhado se ele não mudou de coluna.
+ */
+static void queue_cursor_redraw(AudioEditor *editor) {
+    GtkWidget *area = editor->timeline_drawing_area;
+    if (!area) return;
+    
+    int height = gtk_widget_get_allocated_height(area);
+    int cursor_x = cursor_position_x(editor, gtk_widget_get_allocated_width(area));
+    if (cursor_x == editor->cursor_x) return;
+    
+    if (editor->cursor_x >= 0) {
+        gtk_widget_queue_draw_area(area, editor->cursor_x - CURSOR_STRIP_WIDTH / 2, 0, CURSOR_STRIP_WIDTH, height);
+    }
+    if (cursor_x >= 0) {
+        gtk_widget_queue_draw_area(area, cursor_x - CURSOR_STRIP_WIDTH / 2, 0, CURSOR_STRIP_WIDTH, height);
+    }
+    editor->cursor_x = cursor_x;
+}
+
+static void update_time_label(AudioEditor *editor) {
+    if (!editor->transport_controls) return;
     
-    if (editor->transport_controls) {
-        GList *children = gtk_container_get_children(GTK_CONTAINER(editor->transport_controls));
-        if (children) {
-            GtkWidget *label = GTK_WIDGET(children->data);
-            int seconds = editor->current_position / 100000;
-            int minutes = seconds / 60;
-            seconds %= 60;
-            char time_str[20];
-            snprintf(time_str, sizeof(time_str), "%02d:%02d", minutes, seconds);
+    GList *children = gtk_container_get_children(GTK_CONTAINER(editor->transport_controls));
+    if (children) {
+        GtkWidget *label = GTK_WIDGET(children->data);
+        int seconds = (int)(editor->current_position / 100000);
+        int minutes = seconds / 60;
+        seconds %= 60;
+        char time_str[20];
+        snprintf(time_str, sizeof(time_str), "%02d:%02d", minutes, seconds);
+        if (strcmp(gtk_label_get_text(GTK_LABEL(label)), time_str) != 0) {
             gtk_label_set_text(GTK_LABEL(label), time_str);
-            g_list_free(children);
         }
+        g_list_free(children);
     }
-    
-    return TRUE;
 }
 
-static void on_play(GtkButton *button, gpointer user_data) {
+/*
+ * Roda uma vez por quadro da tela enquanto toca (relógio de quadros do GTK), já
+ * alinhado com o desenho: posiciona o cursor pelo relógio de amostras.
+ */
+static gboolean on_playhead_tick(GtkWidget *widget, GdkFrameClock *frame_clock, gpointer user_data) {
     AudioEditor *editor = (AudioEditor *)user_data;
     
-    if (editor->playing) {
-        return;
+    if (!editor->playing) {
+        editor->playhead_tick = 0;
+        return G_SOURCE_REMOVE;
     }
     
-    if (!editor->audio_buffer || editor->audio_buffer_pos >= editor->audio_buffer_size) {
-        #ifdef USE_SDL2
-        if (editor->audio_device != 0) {
-            SDL_PauseAudioDevice(editor->audio_device, 1);
-            SDL_CloseAudioDevice(editor->audio_device);
-            editor->audio_device = 0;
-        }
-        #endif
-        
-        if (load_audio_for_playback(editor) != 0) {
-            return;
-        }
+    uint64_t frame = playhead_frame(editor, gdk_frame_clock_get_frame_time(frame_clock));
+    if (frame >= editor->playback.total_frames && !editor->scrubbing) {
+        stop_playback(editor);
+        queue_cursor_redraw(editor);
+        editor->playhead_tick = 0;
+        return G_SOURCE_REMOVE;
     }
     
-    if (editor->audio_buffer_pos >= editor->audio_buffer_size) {
-        editor->audio_buffer_pos = 0;
-        editor->current_position = 0;
+    editor->current_position = llround(frame * TIMELINE_UNITS_PER_SECOND / editor->playback.sample_rate);
+    
+    /* O cursor saiu da tela: vira a página para ele ficar na borda esquerda. */
+    double seconds = editor->current_position / TIMELINE_UNITS_PER_SECOND;
+    double x = timeline_x(editor, seconds);
+    if (!editor->scrubbing && (x < 0 || x >= gtk_widget_get_allocated_width(widget))) {
+        set_view(editor, seconds);
     }
     
-    editor->playing = 1;
-    editor->audio_playing = 1;
-    printf("▶️ Reproduzindo...\n");
+    queue_cursor_redraw(editor);
+    update_time_label(editor);
+    
+    return G_SOURCE_CONTINUE;
+}
+
+/*
+ * Reabre os clipes (para ouvir as edições feitas desde a última vez) e o
+ * dispositivo, que fica pausado. Usado pelo Play e pelo scrub com o áudio parado.
+ */
+static int open_playback(AudioEditor *editor) {
+    #ifdef USE_SDL2
+    if (editor->audio_device != 0) {
+        SDL_PauseAudioDevice(editor->audio_device, 1);
+        SDL_CloseAudioDevice(editor->audio_device);
+        editor->audio_device = 0;
+    }
+    #endif
+    
+    if (load_audio_for_playback(editor) != 0) {
+        return -1;
+    }
     
     #ifdef USE_SDL2
     SDL_AudioSpec desired_spec = editor->audio_spec;
@@ -304,17 +659,50 @@ static void on_play(GtkButton *button, gpointer user_data) {
     desired_spec.userdata = editor;
     desired_spec.format = AUDIO_S16SYS;
     
+    editor->audio_device = SDL_OpenAudioDevice(NULL, 0, &desired_spec, &obtained_spec, 0);
     if (editor->audio_device == 0) {
-        editor->audio_device = SDL_OpenAudioDevice(NULL, 0, &desired_spec, &obtained_spec, 0);
-        if (editor->audio_device == 0) {
-            printf("❌ Erro ao abrir dispositivo de áudio: %s\n", SDL_GetError());
-            editor->playing = 0;
-            editor->audio_playing = 0;
-            return;
-        }
-        editor->audio_spec = obtained_spec;
+        printf("❌ Erro ao abrir dispositivo de áudio: %s\n", SDL_GetError());
+        halt_playback(editor);
+        return -1;
+    }
+    editor->audio_spec = obtained_spec;
+    #endif
+    
+    return 0;
+}
+
+/*
+ * Leva a reprodução para "seconds" da linha do tempo. Com grain_seconds > 0 toca
+ * só um grão a partir dali (scrub). Só enfileira o pedido para a thread de
+ * reprodução; nem o dispositivo nem o GTK esperam.
+ */
+static void seek_playback(AudioEditor *editor, double seconds, double grain_seconds) {
+    if (seconds < 0) seconds = 0;
+    editor->current_position = llround(seconds * TIMELINE_UNITS_PER_SECOND);
+    
+    if (!editor->playback.stream) return;
+    
+    uint32_t sample_rate = editor->playback.sample_rate;
+    playback_engine_seek(&editor->playback, (uint64_t)llround(seconds * sample_rate),
+                         (uint64_t)llround(grain_seconds * sample_rate));
+}
+
+static void on_play(GtkButton *button, gpointer user_data) {
+    AudioEditor *editor = (AudioEditor *)user_data;
+    
+    if (editor->playing) {
+        return;
+    }
+    
+    if (open_playback(editor) != 0) {
+        return;
     }
     
+    editor->playing = 1;
+    editor->audio_playing = 1;
+    printf("▶️ Reproduzindo...\n");
+    
+    #ifdef USE_SDL2
     SDL_PauseAudioDevice(editor->audio_device, 0);
     #else
     printf("⚠️ Reprodução de áudio desabilitada (SDL2 não disponível)\n");
@@ -325,21 +713,15 @@ static void on_play(GtkButton *button, gpointer user_data) {
         gtk_statusbar_push(GTK_STATUSBAR(editor->status_bar), 0, "▶️ Reproduzindo...");
     }
     
-    g_timeout_add(50, update_playback, editor);
+    if (editor->playhead_tick == 0 && editor->timeline_drawing_area) {
+        editor->playhead_tick = gtk_widget_add_tick_callback(editor->timeline_drawing_area,
+                                                             on_playhead_tick, editor, NULL);
+    }
 }
 
 static void on_stop(GtkButton *button, gpointer user_data) {
     AudioEditor *editor = (AudioEditor *)user_data;
-    editor->playing = 0;
-    editor->audio_playing = 0;
-    editor->current_position = 0;
-    editor->audio_buffer_pos = 0;
-    
-    #ifdef USE_SDL2
-    if (editor->audio_device != 0) {
-        SDL_PauseAudioDevice(editor->audio_device, 1);
-    }
-    #endif
+    stop_playback(editor);
     
     printf("⏹️ Parado\n");
     
@@ -384,7 +766,7 @@ static void on_export(GtkButton *button, gpointer user_data) {
         
         printf("💾 Exportando para: %s\n", filename);
         
-        int file_count = g_list_length(editor->audio_clips);
+        int file_count = editor->audio_clips.count;
         if (file_count == 0) {
             printf("❌ Nenhum áudio para exportar!\n");
             g_free(filename);
@@ -392,19 +774,11 @@ static void on_export(GtkButton *button, gpointer user_data) {
             return;
         }
         
-        const char **input_files = malloc(file_count * sizeof(char*));
-        float *volumes = malloc(file_count * sizeof(float));
-        float *pans = malloc(file_count * sizeof(float));
-        
-        int i = 0;
-        GList *iter = editor->audio_clips;
-        while (iter != NULL) {
-            AudioClip *clip = (AudioClip *)iter->data;
-            input_files[i] = clip->filename;
-            volumes[i] = clip->volume;
-            pans[i] = clip->pan;
-            i++;
-            iter = g_list_next(iter);
+        MixClip *clips = collect_mix_clips(editor, &file_count);
+        if (!clips) {
+            g_free(filename);
+            gtk_widget_destroy(dialog);
+            return;
         }
         
         if (editor->status_bar) {
@@ -412,7 +786,15 @@ static void on_export(GtkButton *button, gpointer user_data) {
             gtk_statusbar_push(GTK_STATUSBAR(editor->status_bar), 0, "💾 Exportando...");
         }
         
-        if (mix_wav_files(filename, input_files, volumes, pans, file_count) == 0) {
+        /* Exporta no formato de amostra do primeiro clipe (24 bits continua 24 bits). */
+        MixOptions options = { WAV_SAMPLE_S16, RESAMPLE_BEST, MIX_LAYOUT_STEREO };
+        WAV_Info first_info;
+        if (get_wav_info(clips[0].filename, &first_info) == 0 &&
+            wav_sample_format(&first_info) != WAV_SAMPLE_UNSUPPORTED) {
+            options.sample_format = wav_sample_format(&first_info);
+        }
+        
+        if (mix_clips(filename, clips, file_count, &options) == 0) {
             printf("✅ Exportação concluída: %s\n", filename);
             if (editor->status_bar) {
                 char status_msg[200];
@@ -428,9 +810,7 @@ static void on_export(GtkButton *button, gpointer user_data) {
             }
         }
         
-        free(input_files);
-        free(volumes);
-        free(pans);
+        free(clips);
         g_free(filename);
     }
     
@@ -440,7 +820,7 @@ static void on_export(GtkButton *button, gpointer user_data) {
 static void on_remove_audio(GtkButton *button, gpointer user_data) {
     AudioEditor *editor = (AudioEditor *)user_data;
     
-    if (g_list_length(editor->audio_clips) == 0) {
+    if (editor->audio_clips.count == 0) {
         printf("⚠️ Nenhum áudio para remover\n");
         if (editor->status_bar) {
             gtk_statusbar_pop(GTK_STATUSBAR(editor->status_bar), 0);
@@ -463,10 +843,8 @@ static void on_remove_audio(GtkButton *button, gpointer user_data) {
     GtkWidget *list_box = gtk_list_box_new();
     gtk_container_add(GTK_CONTAINER(content_area), list_box);
     
-    GList *iter = editor->audio_clips;
-    int index = 0;
-    while (iter != NULL) {
-        AudioClip *clip = (AudioClip *)iter->data;
+    for (int index = 0; index < editor->audio_clips.count; index++) {
+        AudioClip *clip = clip_at(editor, index);
         const char *filename = strrchr(clip->filename, '/');
         if (!filename) filename = strrchr(clip->filename, '\\');
         if (!filename) filename = clip->filename;
@@ -479,9 +857,6 @@ static void on_remove_audio(GtkButton *button, gpointer user_data) {
         gtk_widget_show_all(row);
         
         g_object_set_data(G_OBJECT(row), "clip-index", GINT_TO_POINTER(index));
-        
-        index++;
-        iter = g_list_next(iter);
     }
     
     gtk_widget_show_all(dialog);
@@ -491,49 +866,45 @@ static void on_remove_audio(GtkButton *button, gpointer user_data) {
         if (selected_row) {
             int clip_index = GPOINTER_TO_INT(g_object_get_data(G_OBJECT(selected_row), "clip-index"));
             
-            iter = editor->audio_clips;
-            int current_index = 0;
-            while (iter != NULL) {
-                if (current_index == clip_index) {
-                    AudioClip *clip = (AudioClip *)iter->data;
-                    const char *filename = strrchr(clip->filename, '/');
-                    if (!filename) filename = strrchr(clip->filename, '\\');
-                    if (!filename) filename = clip->filename;
-                    else filename++;
-                    
-                    printf("🗑️ Removendo: %s\n", filename);
-                    
-                    if (editor->audio_buffer) {
-                        #ifdef USE_SDL2
-                        SDL_FreeWAV((Uint8 *)editor->audio_buffer);
-                        #else
-                        free(editor->audio_buffer);
-                        #endif
-                        editor->audio_buffer = NULL;
-                        editor->audio_buffer_size = 0;
-                        editor->audio_buffer_pos = 0;
-                    }
-                    
-                    g_free(clip->filename);
-                    g_free(clip);
-                    editor->audio_clips = g_list_delete_link(editor->audio_clips, iter);
-                    
-                    if (editor->status_bar) {
-                        char status_msg[200];
-                        snprintf(status_msg, sizeof(status_msg), "🗑️ Removido: %s", filename);
-                        gtk_statusbar_pop(GTK_STATUSBAR(editor->status_bar), 0);
-                        gtk_statusbar_push(GTK_STATUSBAR(editor->status_bar), 0, status_msg);
+            AudioClip *clip = clip_at(editor, clip_index);
+            if (clip) {
+                const char *filename = strrchr(clip->filename, '/');
+                if (!filename) filename = strrchr(clip->filename, '\\');
+                if (!filename) filename = clip->filename;
+                else filename++;
+                
+                printf("🗑️ Removendo: %s\n", filename);
+                
+                /* A reprodução em curso identifica os clipes pela posição na tabela. */
+                if (editor->playing) {
+                    stop_playback(editor);
+                }
+                
+                if (editor->status_bar) {
+                    char status_msg[200];
+                    snprintf(status_msg, sizeof(status_msg), "🗑️ Removido: %s", filename);
+                    gtk_statusbar_pop(GTK_STATUSBAR(editor->status_bar), 0);
+                    gtk_statusbar_push(GTK_STATUSBAR(editor->status_bar), 0, status_msg);
+                }
+                
+                if (editor->selected_clip == clip) {
+                    editor->selected_clip = NULL;
+                    if (editor->volume_scale) {
+                        gtk_widget_set_sensitive(editor->volume_scale, FALSE);
                     }
-                    
-                    update_info_label(editor);
-                    if (editor->timeline_drawing_area) {
-                        gtk_widget_queue_draw(editor->timeline_drawing_area);
+                    if (editor->pan_scale) {
+                        gtk_widget_set_sensitive(editor->pan_scale, FALSE);
                     }
-                    
-                    break;
+                    update_mixer_controls(editor);
+                }
+                clip_table_remove(&editor->audio_clips, clip_index);
+                free_audio_clip(editor, clip);
+                
+                update_info_label(editor);
+                update_clip_layout(editor);
+                if (editor->timeline_drawing_area) {
+                    gtk_widget_queue_draw(editor->timeline_drawing_area);
                 }
-                current_index++;
-                iter = g_list_next(iter);
             }
         }
     }
@@ -546,69 +917,26 @@ static gboolean on_timeline_button_press(GtkWidget *widget, GdkEventButton *even
     
     if (event->button != 1) return FALSE;
     
-    GtkAllocation allocation;
-    gtk_widget_get_allocation(widget, &allocation);
-    int width = allocation.width;
-    int height = allocation.height;
-    
-    int track_height = height / 8;
-    if (track_height < 60) track_height = 60;
-    int num_tracks = height / track_height;
-    if (num_tracks < 1) num_tracks = 1;
+    /* O clique também posiciona o cursor (e a reprodução, se estiver tocando). */
+    seek_playback(editor, timeline_seconds_at(editor, event->x), 0);
     
-    int track_num = 0;
-    GList *iter = editor->audio_clips;
-    while (iter != NULL) {
-        AudioClip *clip = (AudioClip *)iter->data;
-        int track_y = (track_num % num_tracks) * track_height + 5;
+    AudioClip *clip = clip_at_point(editor, event->x, event->y);
+    if (clip) {
+        editor->selected_clip = clip;
+        printf("✅ Clip selecionado: %s\n", clip->filename);
         
-        float clip_seconds = clip->duration / 100000.0f;
-        int clip_width = (int)(clip_seconds * 80.0f);
-        if (clip_width < 400) clip_width = 400;
-        int max_clip_width = width * 2;
-        if (clip_width > max_clip_width) clip_width = max_clip_width;
+        update_mixer_controls(editor);
         
-        int current_track = track_num % num_tracks;
-        int clip_x = 0;
-        GList *prev_iter = editor->audio_clips;
-        int prev_track_idx = 0;
-        while (prev_iter != iter) {
-            AudioClip *prev_clip = (AudioClip *)prev_iter->data;
-            int prev_track = prev_track_idx % num_tracks;
-            if (prev_track == current_track) {
-                float prev_seconds = prev_clip->duration / 100000.0f;
-                int prev_width = (int)(prev_seconds * 80.0f);
-                if (prev_width < 400) prev_width = 400;
-                if (prev_width > width * 2) prev_width = width * 2;
-                clip_x += prev_width + 20;
-            }
-            prev_track_idx++;
-            prev_iter = g_list_next(prev_iter);
+        if (editor->volume_scale) {
+            gtk_widget_set_sensitive(editor->volume_scale, TRUE);
         }
-        
-        int clip_height = track_height - 10;
-        
-        if (event->x >= clip_x && event->x <= clip_x + clip_width &&
-            event->y >= track_y && event->y <= track_y + clip_height) {
-            editor->selected_clip = clip;
-            printf("✅ Clip selecionado: %s\n", clip->filename);
-            
-            update_mixer_controls(editor);
-            
-            if (editor->volume_scale) {
-                gtk_widget_set_sensitive(editor->volume_scale, TRUE);
-            }
-            if (editor->pan_scale) {
-                gtk_widget_set_sensitive(editor->pan_scale, TRUE);
-            }
-            
-            gtk_widget_queue_draw(widget);
-            
-            return TRUE;
+        if (editor->pan_scale) {
+            gtk_widget_set_sensitive(editor->pan_scale, TRUE);
         }
         
-        track_num++;
-        iter = g_list_next(iter);
+        gtk_widget_queue_draw(widget);
+        
+        return TRUE;
     }
     
     editor->selected_clip = NULL;
@@ -624,40 +952,514 @@ static gboolean on_timeline_button_press(GtkWidget *widget, GdkEventButton *even
     return FALSE;
 }
 
-static gboolean draw_timeline(GtkWidget *widget, cairo_t *cr, gpointer user_data) {
+/*
+ * Arrastar com o botão apertado faz scrub: cada movimento toca um grão curto a
+ * partir do ponto sob o mouse. Parado, o dispositivo é aberto no primeiro
+ * movimento e fechado ao soltar o botão.
+ */
+static gboolean on_timeline_motion(GtkWidget *widget, GdkEventMotion *event, gpointer user_data) {
     AudioEditor *editor = (AudioEditor *)user_data;
-    GtkAllocation allocation;
-    gtk_widget_get_allocation(widget, &allocation);
     
-    int width = allocation.width;
-    int height = allocation.height;
+    if (!(event->state & GDK_BUTTON1_MASK)) return FALSE;
     
-    int max_duration = 1000000;
-    GList *iter = editor->audio_clips;
-    while (iter != NULL) {
-        AudioClip *clip = (AudioClip *)iter->data;
-        if (clip->start_pos + clip->duration > max_duration) {
-            max_duration = clip->start_pos + clip->duration;
+    if (!editor->scrubbing) {
+        if (!editor->playing) {
+            if (open_playback(editor) != 0) return FALSE;
+            #ifdef USE_SDL2
+            SDL_PauseAudioDevice(editor->audio_device, 0);
+            #endif
         }
-        iter = g_list_next(iter);
+        editor->scrubbing = 1;
+    }
+    
+    seek_playback(editor, timeline_seconds_at(editor, event->x), SCRUB_GRAIN_SECONDS);
+    queue_cursor_redraw(editor);
+    
+    return TRUE;
+}
+
+static gboolean on_timeline_button_release(GtkWidget *widget, GdkEventButton *event, gpointer user_data) {
+    AudioEditor *editor = (AudioEditor *)user_data;
+    
+    if (event->button != 1 || !editor->scrubbing) return FALSE;
+    
+    editor->scrubbing = 0;
+    if (editor->playing) {
+        /* Volta a tocar normalmente a partir de onde o scrub parou. */
+        seek_playback(editor, timeline_seconds_at(editor, event->x), 0);
+    } else {
+        halt_playback(editor);
+    }
+    queue_cursor_redraw(editor);
+    
+    return TRUE;
+}
+
+/* Espaço entre as linhas da grade: 1, 2 ou 5 vezes uma potência de 10, com pelo menos 50 px. */
+static double grid_step_seconds(double zoom) {
+    static const double multipliers[] = { 1, 2, 5 };
+    for (double base = 0.00001; ; base *= 10) {
+        for (int i = 0; i < 3; i++) {
+            if (base * multipliers[i] * zoom >= 50) return base * multipliers[i];
+        }
+    }
+}
+
+/*
+ * Desenha a waveform nas colunas [left, right) de um clipe que começa em
+ * clip_x, com uma faixa de lane_height pixels por canal a partir de top (L em
+ * cima, R embaixo). O detalhe segue quantos quadros cabem num pixel: a
+ * pirâmide de picos a partir de PEAK_BASE_FRAMES, as amostras do arquivo abaixo
+ * disso e, com mais de um pixel por amostra, uma linha ligando as amostras.
+ * Assim cada coluna custa no máximo um pico do nível 0 por canal, do projeto
+ * inteiro até as amostras. O RMS vai por cima do mínimo/máximo, mais claro, para
+ * diferença de nível entre os canais aparecer mesmo com os picos parecidos.
+ */
+static void draw_clip_waveform(AudioEditor *editor, cairo_t *cr, AudioClip *clip, double clip_x,
+                               int left, int right, int top, double lane_height) {
+    PeakPyramid *peaks = clip->peaks;
+    int16_t max_abs = peaks->max_abs;
+    if (max_abs == 0) max_abs = 1;
+    if (peaks->frames == 0 || right <= left) return;
+    
+    int channels = peaks->channels;
+    double half_height = lane_height * 0.45;
+    double frames_per_pixel = peaks->sample_rate / editor->zoom_level;
+    
+    if (frames_per_pixel < 1.0) {
+        if (!clip->reader) return;
+        
+        double first = floor((left - clip_x) * frames_per_pixel) - 1;
+        double last = ceil((right - clip_x) * frames_per_pixel) + 1;
+        if (first < 0) first = 0;
+        if (last > peaks->frames - 1) last = (double)(peaks->frames - 1);
+        
+        for (int channel = 0; channel < channels; channel++) {
+            double center_y = top + lane_height * channel + lane_height / 2;
+            for (uint64_t frame = (uint64_t)first; frame <= (uint64_t)last; frame++) {
+                float value = wav_reader_sample(clip->reader, (size_t)frame, (uint16_t)channel) / max_abs;
+                double x = clip_x + frame / frames_per_pixel;
+                double y = center_y + value * half_height;
+                if (frame == (uint64_t)first) {
+                    cairo_move_to(cr, x, y);
+                } else {
+                    cairo_line_to(cr, x, y);
+                }
+            }
+        }
+        cairo_stroke(cr);
+        return;
+    }
+    
+    /* RMS de cada coluna e canal, guardado para a segunda passada (-1 = sem pico). */
+    int16_t *rms = g_new(int16_t, (size_t)(right - left) * channels);
+    
+    for (int x = left; x < right; x++) {
+        int16_t *column_rms = rms + (size_t)(x - left) * channels;
+        for (int channel = 0; channel < channels; channel++) {
+            column_rms[channel] = -1;
+        }
+        
+        double first = (x - clip_x) * frames_per_pixel;
+        double end = (x + 1 - clip_x) * frames_per_pixel;
+        if (first < 0) first = 0;
+        if (end > peaks->frames) end = (double)peaks->frames;
+        if (end <= first) continue;
+        
+        PeakValue peak[PEAK_MAX_CHANNELS];
+        int result = -1;
+        if (frames_per_pixel >= PEAK_BASE_FRAMES) {
+            result = peak_pyramid_query(peaks, (uint64_t)first, (uint64_t)end, peak);
+        } else if (clip->reader) {
+            result = peak_read_range(clip->reader, (uint64_t)first, (uint64_t)end, peak);
+        }
+        if (result != 0) continue;
+        
+        for (int channel = 0; channel < channels; channel++) {
+            int center_y = top + (int)(lane_height * channel + lane_height / 2);
+            float min_norm = (float)peak[channel].min / (float)max_abs;
+            float max_norm = (float)peak[channel].max / (float)max_abs;
+            
+            int y1 = center_y + (int)(min_norm * half_height);
+            int y2 = center_y + (int)(max_norm * half_height);
+            
+            if (y1 == y2) {
+                y1 = center_y - 1;
+                y2 = center_y + 1;
+            }
+            
+            cairo_move_to(cr, x, y1);
+            cairo_line_to(cr, x, y2);
+            column_rms[channel] = peak[channel].rms;
+        }
+    }
+    cairo_stroke(cr);
+    
+    cairo_set_source_rgba(cr, 1.0, 1.0, 1.0, 0.35);
+    for (int x = left; x < right; x++) {
+        const int16_t *column_rms = rms + (size_t)(x - left) * channels;
+        for (int channel = 0; channel < channels; channel++) {
+            if (column_rms[channel] <= 0) continue;
+            int center_y = top + (int)(lane_height * channel + lane_height / 2);
+            int extent = (int)((float)column_rms[channel] / (float)max_abs * half_height);
+            if (extent == 0) continue;
+            cairo_move_to(cr, x, center_y - extent);
+            cairo_line_to(cr, x, center_y + extent);
+        }
+    }
+    cairo_stroke(cr);
+    
+    g_free(rms);
+}
+
+/* Área da waveform (ou do espectrograma) de um clipe da faixa track, abaixo dos textos. */
+static void clip_waveform_area(int track, int *y, int *height) {
+    int text_area_height = 25;
+    *y = track * TRACK_HEIGHT + 5 + text_area_height;
+    *height = TRACK_HEIGHT - 10 - text_area_height - 5;
+}
+
+/* Cor do clipe pela posição na tabela, em rodízio de seis. */
+static void clip_color(int index, float *r, float *g, float *b) {
+    float hue = (index % 6) / 6.0f;
+    if (hue < 0.17f) { *r = 0.2f; *g = 0.6f; *b = 0.9f; }
+    else if (hue < 0.33f) { *r = 0.4f; *g = 0.8f; *b = 0.3f; }
+    else if (hue < 0.5f) { *r = 0.9f; *g = 0.5f; *b = 0.2f; }
+    else if (hue < 0.67f) { *r = 0.9f; *g = 0.3f; *b = 0.6f; }
+    else if (hue < 0.83f) { *r = 0.7f; *g = 0.4f; *b = 0.9f; }
+    else { *r = 0.3f; *g = 0.8f; *b = 0.9f; }
+}
+
+/*
+ * Fundo, borda e waveform do clipe entre as colunas left e right. Só esse
+ * trecho do retângulo é desenhado: de perto o clipe inteiro teria bilhões de
+ * pixels, além do que o cairo representa. A borda fica fora do trecho quando
+ * a ponta do clipe não está nele.
+ */
+static void draw_clip_body(AudioEditor *editor, cairo_t *cr, AudioClip *clip,
+                           double clip_x, double clip_width, double left, double right) {
+    int track = editor->audio_clips.track[clip->index];
+    int track_y = track * TRACK_HEIGHT + 5;
+    int clip_height = TRACK_HEIGHT - 10;
+    float r, g, b;
+    clip_color(clip->index, &r, &g, &b);
+    
+    double rect_left = clip_x > left - 4 ? clip_x : left - 4;
+    double rect_right = clip_x + clip_width < right + 4 ? clip_x + clip_width : right + 4;
+    
+    cairo_pattern_t *clip_pattern = cairo_pattern_create_linear(rect_left, track_y, rect_left, track_y + clip_height);
+    cairo_pattern_add_color_stop_rgb(clip_pattern, 0.0, r * 0.25, g * 0.25, b * 0.25);
+    cairo_pattern_add_color_stop_rgb(clip_pattern, 1.0, r * 0.15, g * 0.15, b * 0.15);
+    cairo_set_source(cr, clip_pattern);
+    cairo_rectangle(cr, rect_left, track_y, rect_right - rect_left, clip_height);
+    cairo_fill(cr);
+    cairo_pattern_destroy(clip_pattern);
+    
+    if (editor->selected_clip == clip) {
+        cairo_set_source_rgb(cr, 1.0, 0.9, 0.3);
+        cairo_set_line_width(cr, 4);
+    } else {
+        cairo_set_source_rgb(cr, r, g, b);
+        cairo_set_line_width(cr, 2.5);
+    }
+    cairo_rectangle(cr, rect_left, track_y, rect_right - rect_left, clip_height);
+    cairo_stroke(cr);
+    
+    int waveform_area_y, waveform_area_height;
+    clip_waveform_area(track, &waveform_area_y, &waveform_area_height);
+    
+    if (clip->peaks && !editor->show_spectrogram && waveform_area_height > 15) {
+        double lane_height = (double)waveform_area_height / clip->peaks->channels;
+        
+        cairo_set_source_rgba(cr, 0.4, 0.4, 0.5, 0.3);
+        cairo_set_line_width(cr, 0.5);
+        for (int channel = 0; channel < clip->peaks->channels; channel++) {
+            int center_y = waveform_area_y + (int)(lane_height * channel + lane_height / 2);
+            cairo_move_to(cr, rect_left, center_y);
+            cairo_line_to(cr, rect_right, center_y);
+        }
+        cairo_stroke(cr);
+        
+        cairo_set_source_rgb(cr, r * 0.7, g * 0.7, b * 0.7);
+        cairo_set_line_width(cr, 2.0);
+        draw_clip_waveform(editor, cr, clip, clip_x, (int)floor(left > clip_x ? left : clip_x),
+                           (int)ceil(right < clip_x + clip_width ? right : clip_x + clip_width),
+                           waveform_area_y, lane_height);
+    }
+}
+
+/*
+ * Espectrograma do clipe nas colunas [left, right), na área da waveform. Os
+ * ladrilhos prontos são esticados para o zoom atual; os que faltam são pedidos
+ * às threads e aparecem no redesenho de quando ficarem prontos.
+ */
+static void draw_clip_spectrogram(AudioEditor *editor, cairo_t *cr, AudioClip *clip,
+                                  double clip_x, double left, double right) {
+    Spectrogram *spectrogram = clip->spectrogram;
+    if (spectrogram->frames == 0 || right <= left) return;
+    
+    int area_y, area_height;
+    clip_waveform_area(editor->audio_clips.track[clip->index], &area_y, &area_height);
+    
+    double frames_per_pixel = spectrogram->sample_rate / editor->zoom_level;
+    int level = spectrogram_level(frames_per_pixel);
+    double column_width = (double)((uint64_t)1 << level) / frames_per_pixel;
+    double tile_width = column_width * SPECTROGRAM_TILE_COLUMNS;
+    uint64_t last_tile = ((spectrogram->frames - 1) >> level) / SPECTROGRAM_TILE_COLUMNS;
+    
+    double first_tile = floor((left - clip_x) / tile_width);
+    if (first_tile < 0) first_tile = 0;
+    
+    for (uint64_t index = (uint64_t)first_tile; index <= last_tile; index++) {
+        double tile_x = clip_x + index * tile_width;
+        if (tile_x >= right) break;
+        
+        /* Os pixels só valem até o próximo pedido: o ladrilho é desenhado já. */
+        const uint32_t *pixels = spectrogram_tile(editor->spectrogram_engine, spectrogram, level, index);
+        if (!pixels) continue;
+        
+        cairo_surface_t *surface = cairo_image_surface_create_for_data((unsigned char *)pixels, CAIRO_FORMAT_ARGB32,
+                                                                       SPECTROGRAM_TILE_COLUMNS, SPECTROGRAM_TILE_ROWS,
+                                                                       SPECTROGRAM_TILE_COLUMNS * sizeof(uint32_t));
+        cairo_save(cr);
+        cairo_rectangle(cr, left, area_y, right - left, area_height);
+        cairo_clip(cr);
+        cairo_translate(cr, tile_x, area_y);
+        cairo_scale(cr, column_width, (double)area_height / SPECTROGRAM_TILE_ROWS);
+        cairo_set_source_surface(cr, surface, 0, 0);
+        cairo_pattern_set_filter(cairo_get_source(cr), CAIRO_FILTER_FAST);
+        cairo_paint(cr);
+        cairo_restore(cr);
+        cairo_surface_destroy(surface);
+    }
+}
+
+/*
+ * Porcentagem do carregamento da waveform que aparece no texto do clipe: -1 se
+ * ela não pôde ser calculada, 100 quando está completa (sem aviso).
+ */
+static int clip_label_progress(AudioClip *clip) {
+    if (!clip->peaks) return -1;
+    float progress = peak_pyramid_progress(clip->peaks);
+    if (progress >= 1.0f) return 100;
+    return progress < 0.99f ? (int)(progress * 100) : 99;
+}
+
+/* Nome do arquivo do clipe, sem o diretório. */
+static const char *clip_display_name(AudioClip *clip) {
+    const char *filename = strrchr(clip->filename, '/');
+    if (!filename) filename = strrchr(clip->filename, '\\');
+    return filename ? filename + 1 : clip->filename;
+}
+
+/* Nome, volume/pan e o aviso de carregamento de um clipe cujo canto é (x, y). */
+static void draw_clip_label(cairo_t *cr, AudioClip *clip, float volume, float pan, double x, double y) {
+    int clip_height = TRACK_HEIGHT - 10;
+    float r, g, b;
+    clip_color(clip->index, &r, &g, &b);
+    
+    cairo_set_source_rgba(cr, 0.0, 0.0, 0.0, 0.5);
+    cairo_select_font_face(cr, "Sans", CAIRO_FONT_SLANT_NORMAL, CAIRO_FONT_WEIGHT_BOLD);
+    cairo_set_font_size(cr, 11);
+    const char *filename = clip_display_name(clip);
+    cairo_move_to(cr, x + 6, y + 16);
+    cairo_show_text(cr, filename);
+    
+    cairo_set_source_rgb(cr, 1.0, 1.0, 1.0);
+    cairo_move_to(cr, x + 5, y + 15);
+    cairo_show_text(cr, filename);
+    
+    char info[50];
+    snprintf(info, sizeof(info), "V:%.1f P:%.1f", volume, pan);
+    cairo_set_font_size(cr, 9);
+    cairo_set_source_rgb(cr, r * 0.8, g * 0.8, b * 0.8);
+    cairo_move_to(cr, x + 5, y + 25);
+    cairo_show_text(cr, info);
+    
+    int progress = clip_label_progress(clip);
+    if (progress < 100) {
+        char loading[64];
+        if (progress >= 0) {
+            snprintf(loading, sizeof(loading), "⏳ Carregando waveform... %d%%", progress);
+        } else {
+            snprintf(loading, sizeof(loading), "⏳ Carregando waveform...");
+        }
+        cairo_set_source_rgba(cr, 0.6, 0.6, 0.6, 0.7);
+        cairo_set_font_size(cr, 10);
+        cairo_move_to(cr, x + 5, y + 25 + (clip_height - 30) / 2);
+        cairo_show_text(cr, loading);
+    }
+}
+
+/*
+ * Marca o clipe como o último desenhado. Passando de CLIP_SURFACE_CACHE_MAX,
+ * o desenho do clipe usado há mais tempo (fora da tela) é descartado.
+ */
+static void touch_clip_surfaces(AudioEditor *editor, AudioClip *clip) {
+    ClipSurfaces *surfaces = &clip->surfaces;
+    if (surfaces->lru_link) {
+        g_queue_unlink(&editor->clip_surfaces, surfaces->lru_link);
+    } else {
+        surfaces->lru_link = g_list_alloc();
+        surfaces->lru_link->data = clip;
+    }
+    g_queue_push_head_link(&editor->clip_surfaces, surfaces->lru_link);
+    
+    while (g_queue_get_length(&editor->clip_surfaces) > CLIP_SURFACE_CACHE_MAX) {
+        free_clip_surfaces(editor, (AudioClip *)g_queue_peek_tail_link(&editor->clip_surfaces)->data);
+    }
+}
+
+/*
+ * Corpo do clipe já desenhado, cobrindo ao menos o que aparece numa área de
+ * largura width, e a coluna onde colá-lo em *origin_x. É refeito quando mudam
+ * o zoom, a faixa, a cor, a seleção ou o progresso da waveform, ou quando a
+ * rolagem sai do trecho guardado (meia tela para cada lado do que está visível).
+ */
+static cairo_surface_t *clip_body_surface(AudioEditor *editor, GtkWidget *widget, AudioClip *clip,
+                                          double clip_x, double clip_width, int width, double *origin_x) {
+    ClipSurfaces *surfaces = &clip->surfaces;
+    int track = editor->audio_clips.track[clip->index];
+    int selected = editor->selected_clip == clip;
+    float progress = clip->peaks ? peak_pyramid_progress(clip->peaks) : 0.0f;
+    
+    double visible_left = clip_x < 0 ? -clip_x : 0;
+    double visible_right = clip_x + clip_width > width ? width - clip_x : clip_width;
+    
+    if (!surfaces->body || surfaces->body_zoom != editor->zoom_level || surfaces->body_track != track ||
+        surfaces->body_index != clip->index ||
+        surfaces->body_selected != selected || surfaces->body_progress != progress ||
+        surfaces->body_spectrogram != editor->show_spectrogram ||
+        visible_left < surfaces->body_left || visible_right > surfaces->body_left + surfaces->body_width) {
+        double left = visible_left - width / 2;
+        double right = visible_right + width / 2;
+        if (left < 0) left = 0;
+        if (right > clip_width) right = clip_width;
+        
+        /* A origem cai numa coluna inteira, como as colunas da waveform. */
+        double origin = floor(clip_x + left);
+        int surface_width = (int)ceil(clip_x + right - origin);
+        if (surface_width < 1) surface_width = 1;
+        
+        if (surfaces->body) cairo_surface_destroy(surfaces->body);
+        surfaces->body = gdk_window_create_similar_surface(gtk_widget_get_window(widget), CAIRO_CONTENT_COLOR_ALPHA,
+                                                           surface_width, TRACK_HEIGHT);
+        cairo_t *body_cr = cairo_create(surfaces->body);
+        cairo_translate(body_cr, -origin, -track * TRACK_HEIGHT);
+        draw_clip_body(editor, body_cr, clip, clip_x, clip_width, origin, origin + surface_width);
+        cairo_destroy(body_cr);
+        
+        surfaces->body_zoom = editor->zoom_level;
+        surfaces->body_left = origin - clip_x;
+        surfaces->body_width = surface_width;
+        surfaces->body_track = track;
+        surfaces->body_index = clip->index;
+        surfaces->body_selected = selected;
+        surfaces->body_progress = progress;
+        surfaces->body_spectrogram = editor->show_spectrogram;
     }
-    if (max_duration < 1000000) max_duration = 1000000;
     
-    int total_clips_width = 0;
-    iter = editor->audio_clips;
-    while (iter != NULL) {
-        AudioClip *clip = (AudioClip *)iter->data;
-        float clip_seconds = clip->duration / 100000.0f;
-        int clip_w = (int)(clip_seconds * 80.0f);
-        if (clip_w < 400) clip_w = 400;
-        total_clips_width += clip_w + 20;
-        iter = g_list_next(iter);
+    *origin_x = round(clip_x + surfaces->body_left);
+    return surfaces->body;
+}
+
+/* Textos do clipe já desenhados; refeitos quando mudam volume, pan, cor ou carregamento. */
+static cairo_surface_t *clip_label_surface(AudioEditor *editor, GtkWidget *widget, cairo_t *cr, AudioClip *clip) {
+    ClipSurfaces *surfaces = &clip->surfaces;
+    float volume = editor->audio_clips.volume[clip->index];
+    float pan = editor->audio_clips.pan[clip->index];
+    int progress = clip_label_progress(clip);
+    
+    if (surfaces->label && surfaces->label_volume == volume && surfaces->label_pan == pan &&
+        surfaces->label_index == clip->index && surfaces->label_progress == progress) {
+        return surfaces->label;
     }
     
-    if (total_clips_width > width) {
-        gtk_widget_set_size_request(editor->timeline_drawing_area, total_clips_width, 500);
+    /* Largura do texto mais comprido (nome, volume/pan ou aviso de carregamento). */
+    cairo_text_extents_t extents;
+    cairo_save(cr);
+    cairo_select_font_face(cr, "Sans", CAIRO_FONT_SLANT_NORMAL, CAIRO_FONT_WEIGHT_BOLD);
+    cairo_set_font_size(cr, 11);
+    cairo_text_extents(cr, clip_display_name(clip), &extents);
+    double label_width = extents.x_advance;
+    cairo_set_font_size(cr, 9);
+    cairo_text_extents(cr, "V:0.0 P:-0.0", &extents);
+    if (extents.x_advance > label_width) label_width = extents.x_advance;
+    cairo_set_font_size(cr, 10);
+    cairo_text_extents(cr, "⏳ Carregando waveform... 100%", &extents);
+    if (progress < 100 && extents.x_advance > label_width) label_width = extents.x_advance;
+    cairo_restore(cr);
+    
+    if (surfaces->label) cairo_surface_destroy(surfaces->label);
+    surfaces->label = gdk_window_create_similar_surface(gtk_widget_get_window(widget), CAIRO_CONTENT_COLOR_ALPHA,
+                                                        (int)ceil(label_width) + 12, TRACK_HEIGHT - 10);
+    cairo_t *label_cr = cairo_create(surfaces->label);
+    draw_clip_label(label_cr, clip, volume, pan, 0, 0);
+    cairo_destroy(label_cr);
+    
+    surfaces->label_volume = volume;
+    surfaces->label_pan = pan;
+    surfaces->label_index = clip->index;
+    surfaces->label_progress = progress;
+    return surfaces->label;
+}
+
+/*
+ * Cola o corpo e os textos de um clipe, das superfícies guardadas, no trecho
+ * [clip_left, clip_right] da área; os textos acompanham a borda da tela quando
+ * o começo do clipe sai dela.
+ */
+static void draw_clip(AudioEditor *editor, GtkWidget *widget, cairo_t *cr, AudioClip *clip, int width,
+                      double clip_left, double clip_right) {
+    const ClipTable *table = &editor->audio_clips;
+    int track_y = table->track[clip->index] * TRACK_HEIGHT + 5;
+    int clip_height = TRACK_HEIGHT - 10;
+    
+    double clip_x = timeline_x(editor, table->start_pos[clip->index] / TIMELINE_UNITS_PER_SECOND);
+    double clip_width = table->duration[clip->index] / TIMELINE_UNITS_PER_SECOND * editor->zoom_level;
+    
+    if (clip_x + clip_width + 3 < clip_left || clip_x - 3 > clip_right) {
+        return;
     }
     
+    double origin_x;
+    cairo_surface_t *body = clip_body_surface(editor, widget, clip, clip_x, clip_width, width, &origin_x);
+    cairo_set_source_surface(cr, body, origin_x, track_y - 5);
+    cairo_rectangle(cr, origin_x, track_y - 5, clip->surfaces.body_width, TRACK_HEIGHT);
+    cairo_fill(cr);
+    
+    double left = clip_x > clip_left ? clip_x : clip_left;
+    double right = clip_x + clip_width < clip_right ? clip_x + clip_width : clip_right;
+    if (editor->show_spectrogram && clip->spectrogram) {
+        draw_clip_spectrogram(editor, cr, clip, clip_x, left, right);
+    }
+    
+    cairo_surface_t *label = clip_label_surface(editor, widget, cr, clip);
+    cairo_save(cr);
+    cairo_rectangle(cr, left, track_y, right - left, clip_height);
+    cairo_clip(cr);
+    cairo_set_source_surface(cr, label, round(clip_x > 0 ? clip_x : 0), track_y);
+    cairo_paint(cr);
+    cairo_restore(cr);
+    
+    touch_clip_surfaces(editor, clip);
+}
+
+static gboolean draw_timeline(GtkWidget *widget, cairo_t *cr, gpointer user_data) {
+    AudioEditor *editor = (AudioEditor *)user_data;
+    GtkAllocation allocation;
+    gtk_widget_get_allocation(widget, &allocation);
+    
+    int width = allocation.width;
+    int height = allocation.height;
+    
+    /*
+     * Só a região invalidada (no máximo o que aparece na janela) é pintada:
+     * faixas e clipes fora dela nem são visitados.
+     */
+    double clip_left, clip_top, clip_right, clip_bottom;
+    cairo_clip_extents(cr, &clip_left, &clip_top, &clip_right, &clip_bottom);
+    
     cairo_pattern_t *bg_pattern = cairo_pattern_create_linear(0, 0, 0, height);
     cairo_pattern_add_color_stop_rgb(bg_pattern, 0.0, 0.08, 0.08, 0.12);
     cairo_pattern_add_color_stop_rgb(bg_pattern, 1.0, 0.05, 0.05, 0.08);
@@ -666,214 +1468,97 @@ static gboolean draw_timeline(GtkWidget *widget, cairo_t *cr, gpointer user_data
     cairo_fill(cr);
     cairo_pattern_destroy(bg_pattern);
     
+    /* A grade marca tempos redondos e anda junto com a rolagem. */
     cairo_set_source_rgba(cr, 0.2, 0.3, 0.5, 0.3);
     cairo_set_line_width(cr, 1);
     
-    for (int i = 0; i < width; i += 50) {
-        cairo_move_to(cr, i, 0);
-        cairo_line_to(cr, i, height);
+    double grid_step = grid_step_seconds(editor->zoom_level);
+    for (long long i = (long long)floor(timeline_seconds_at(editor, clip_left) / grid_step); ; i++) {
+        double x = floor(timeline_x(editor, i * grid_step)) + 0.5;
+        if (x > clip_right) break;
+        cairo_move_to(cr, x, clip_top);
+        cairo_line_to(cr, x, clip_bottom);
     }
     cairo_stroke(cr);
     
-    int track_height = height / 8;
-    if (track_height < 60) track_height = 60;
-    int num_tracks = height / track_height;
-    if (num_tracks < 1) num_tracks = 1;
+    int first_track = clip_top > 0 ? (int)(clip_top / TRACK_HEIGHT) : 0;
+    int last_track = (int)(clip_bottom / TRACK_HEIGHT);
     
     cairo_set_source_rgba(cr, 0.3, 0.5, 0.7, 0.4);
     cairo_set_line_width(cr, 1.5);
-    for (int i = 1; i < num_tracks; i++) {
-        cairo_move_to(cr, 0, i * track_height);
-        cairo_line_to(cr, width, i * track_height);
+    for (int i = first_track > 1 ? first_track : 1; i <= last_track; i++) {
+        cairo_move_to(cr, clip_left, i * TRACK_HEIGHT);
+        cairo_line_to(cr, clip_right, i * TRACK_HEIGHT);
     }
     cairo_stroke(cr);
     
-    int track_num = 0;
-    iter = editor->audio_clips;
-    while (iter != NULL) {
-        AudioClip *clip = (AudioClip *)iter->data;
-        int track_y = (track_num % num_tracks) * track_height + 5;
-        
-        float clip_seconds = clip->duration / 100000.0f;
-        int clip_width = (int)(clip_seconds * 80.0f);
-        
-        if (clip_width < 400) clip_width = 400;
-        
-        int max_clip_width = width * 2;
-        if (clip_width > max_clip_width) {
-            clip_width = max_clip_width;
-        }
-        
-        int current_track = track_num % num_tracks;
-        int clip_x = 0;
-        GList *prev_iter = editor->audio_clips;
-        int prev_track_idx = 0;
-        while (prev_iter != iter) {
-            AudioClip *prev_clip = (AudioClip *)prev_iter->data;
-            int prev_track = prev_track_idx % num_tracks;
-            if (prev_track == current_track) {
-                float prev_seconds = prev_clip->duration / 100000.0f;
-                int prev_width = (int)(prev_seconds * 80.0f);
-                if (prev_width < 400) prev_width = 400;
-                if (prev_width > width * 2) prev_width = width * 2;
-                clip_x += prev_width + 20;
-            }
-            prev_track_idx++;
-            prev_iter = g_list_next(prev_iter);
+    /* O índice de cada faixa entrega só os clipes que cruzam o trecho visível. */
+    int64_t first_position = timeline_position_at(editor, clip_left - 3);
+    int64_t end_position = timeline_position_at(editor, clip_right + 3);
+    if (last_track >= TRACK_COUNT) last_track = TRACK_COUNT - 1;
+    const ClipTable *table = &editor->audio_clips;
+    for (int t = first_track; t <= last_track; t++) {
+        const ClipTrack *track = &editor->tracks[t];
+        for (int i = track_first_clip(track, first_position); i < track->count; i++) {
+            int index = track->clips[i];
+            if (table->start_pos[index] > end_position) break;
+            draw_clip(editor, widget, cr, table->items[index], width, clip_left, clip_right);
         }
-        
-        int clip_height = track_height - 10;
-        
-        float hue = (track_num % 6) / 6.0f;
-        float r, g, b;
-        if (hue < 0.17f) { r = 0.2f; g = 0.6f; b = 0.9f; }
-        else if (hue < 0.33f) { r = 0.4f; g = 0.8f; b = 0.3f; }
-        else if (hue < 0.5f) { r = 0.9f; g = 0.5f; b = 0.2f; }
-        else if (hue < 0.67f) { r = 0.9f; g = 0.3f; b = 0.6f; }
-        else if (hue < 0.83f) { r = 0.7f; g = 0.4f; b = 0.9f; }
-        else { r = 0.3f; g = 0.8f; b = 0.9f; }
-        
-        cairo_pattern_t *clip_pattern = cairo_pattern_create_linear(clip_x, track_y, clip_x, track_y + clip_height);
-        cairo_pattern_add_color_stop_rgb(clip_pattern, 0.0, r * 0.25, g * 0.25, b * 0.25);
-        cairo_pattern_add_color_stop_rgb(clip_pattern, 1.0, r * 0.15, g * 0.15, b * 0.15);
-        cairo_set_source(cr, clip_pattern);
-        cairo_rectangle(cr, clip_x, track_y, clip_width, clip_height);
-        cairo_fill(cr);
-        cairo_pattern_destroy(clip_pattern);
-        
-        if (editor->selected_clip == clip) {
-            cairo_set_source_rgb(cr, 1.0, 0.9, 0.3);
-            cairo_set_line_width(cr, 4);
-        } else {
-            cairo_set_source_rgb(cr, r, g, b);
-            cairo_set_line_width(cr, 2.5);
-        }
-        cairo_rectangle(cr, clip_x, track_y, clip_width, clip_height);
+    }
+    
+    int cursor_x = cursor_position_x(editor, width);
+    editor->cursor_x = cursor_x;
+    if (cursor_x >= 0) {
+        cairo_set_source_rgba(cr, 1.0, 0.8, 0.0, 0.3);
+        cairo_set_line_width(cr, 4);
+        cairo_move_to(cr, cursor_x, 0);
+        cairo_line_to(cr, cursor_x, height);
         cairo_stroke(cr);
         
-        int text_area_height = 25;
-        int waveform_area_y = track_y + text_area_height;
-        int waveform_area_height = clip_height - text_area_height - 5;
-        
-        cairo_set_source_rgba(cr, 0.0, 0.0, 0.0, 0.5);
-        cairo_select_font_face(cr, "Sans", CAIRO_FONT_SLANT_NORMAL, CAIRO_FONT_WEIGHT_BOLD);
-        cairo_set_font_size(cr, 11);
-        const char *filename = strrchr(clip->filename, '/');
-        if (!filename) filename = strrchr(clip->filename, '\\');
-        if (!filename) filename = clip->filename;
-        else filename++;
-        cairo_move_to(cr, clip_x + 6, track_y + 16);
-        cairo_show_text(cr, filename);
-        
-        cairo_set_source_rgb(cr, 1.0, 1.0, 1.0);
-        cairo_move_to(cr, clip_x + 5, track_y + 15);
-        cairo_show_text(cr, filename);
-        
-        char info[50];
-        snprintf(info, sizeof(info), "V:%.1f P:%.1f", clip->volume, clip->pan);
-        cairo_set_font_size(cr, 9);
-        cairo_set_source_rgb(cr, r * 0.8, g * 0.8, b * 0.8);
-        cairo_move_to(cr, clip_x + 5, track_y + 25);
-        cairo_show_text(cr, info);
-        
-        int16_t *waveform_samples = NULL;
-        size_t waveform_count = 0;
-        int max_waveform_samples = clip_width * 4;
-        if (read_wav_samples(clip->filename, &waveform_samples, &waveform_count, max_waveform_samples) == 0 && waveform_count > 0) {
-            if (waveform_area_height > 15) {
-                cairo_set_source_rgb(cr, 0.2, 0.9, 0.4);
-                cairo_set_line_width(cr, 1.5);
-                
-                int samples_per_pixel = waveform_count / clip_width;
-                if (samples_per_pixel < 1) samples_per_pixel = 1;
-                
-                int center_y = waveform_area_y + waveform_area_height / 2;
-                
-                cairo_set_source_rgba(cr, 0.4, 0.4, 0.5, 0.3);
-                cairo_set_line_width(cr, 0.5);
-                cairo_move_to(cr, clip_x, center_y);
-                cairo_line_to(cr, clip_x + clip_width, center_y);
-                cairo_stroke(cr);
-                
-                cairo_set_source_rgb(cr, r * 0.7, g * 0.7, b * 0.7);
-                cairo_set_line_width(cr, 2.0);
-                
-                int16_t max_abs = 0;
-                for (size_t i = 0; i < waveform_count; i++) {
-                    int16_t abs_val = waveform_samples[i] < 0 ? -waveform_samples[i] : waveform_samples[i];
-                    if (abs_val > max_abs) max_abs = abs_val;
-                }
-                if (max_abs == 0) max_abs = 1;
-                
-                for (int x = 0; x < clip_width && x * samples_per_pixel < (int)waveform_count; x++) {
-                    int sample_idx = x * samples_per_pixel;
-                    if (sample_idx >= (int)waveform_count) break;
-                    
-                    int16_t min_val = waveform_samples[sample_idx];
-                    int16_t max_val = waveform_samples[sample_idx];
-                    int end_idx = sample_idx + samples_per_pixel;
-                    if (end_idx > (int)waveform_count) end_idx = waveform_count;
-                    
-                    for (int i = sample_idx; i < end_idx; i++) {
-                        if (waveform_samples[i] < min_val) min_val = waveform_samples[i];
-                        if (waveform_samples[i] > max_val) max_val = waveform_samples[i];
-                    }
-                    
-                    float min_norm = (float)min_val / (float)max_abs;
-                    float max_norm = (float)max_val / (float)max_abs;
-                    
-                    int y1 = center_y + (int)(min_norm * waveform_area_height * 0.45f);
-                    int y2 = center_y + (int)(max_norm * waveform_area_height * 0.45f);
-                    
-                    if (y1 == y2) {
-                        y1 = center_y - 1;
-                        y2 = center_y + 1;
-                    }
-                    
-                    cairo_move_to(cr, clip_x + x, y1);
-                    cairo_line_to(cr, clip_x + x, y2);
-                }
-                cairo_stroke(cr);
-                
-                free(waveform_samples);
-            }
-        } else {
-            cairo_set_source_rgba(cr, 0.6, 0.6, 0.6, 0.7);
-            cairo_set_font_size(cr, 10);
-            cairo_move_to(cr, clip_x + 5, waveform_area_y + waveform_area_height / 2);
-            cairo_show_text(cr, "⏳ Carregando waveform...");
-        }
+        cairo_set_source_rgb(cr, 1.0, 0.7, 0.2);
+        cairo_set_line_width(cr, 3);
+        cairo_move_to(cr, cursor_x, 0);
+        cairo_line_to(cr, cursor_x, height);
+        cairo_stroke(cr);
         
-        track_num++;
-        iter = g_list_next(iter);
-    }
-    
-    if (editor->playing || editor->current_position > 0) {
-        int cursor_x = (editor->current_position * width) / max_duration;
-        if (cursor_x >= 0 && cursor_x < width) {
-            cairo_set_source_rgba(cr, 1.0, 0.8, 0.0, 0.3);
-            cairo_set_line_width(cr, 4);
-            cairo_move_to(cr, cursor_x, 0);
-            cairo_line_to(cr, cursor_x, height);
-            cairo_stroke(cr);
-            
-            cairo_set_source_rgb(cr, 1.0, 0.7, 0.2);
-            cairo_set_line_width(cr, 3);
-            cairo_move_to(cr, cursor_x, 0);
-            cairo_line_to(cr, cursor_x, height);
-            cairo_stroke(cr);
-            
-            cairo_set_source_rgb(cr, 1.0, 1.0, 0.5);
-            cairo_set_line_width(cr, 1);
-            cairo_move_to(cr, cursor_x, 0);
-            cairo_line_to(cr, cursor_x, height);
-            cairo_stroke(cr);
-        }
+        cairo_set_source_rgb(cr, 1.0, 1.0, 0.5);
+        cairo_set_line_width(cr, 1);
+        cairo_move_to(cr, cursor_x, 0);
+        cairo_line_to(cr, cursor_x, height);
+        cairo_stroke(cr);
     }
     
     return FALSE;
 }
 
+/* Os botões de zoom mantêm parado o centro da tela. */
+static void on_zoom_in(GtkButton *button, gpointer user_data) {
+    AudioEditor *editor = (AudioEditor *)user_data;
+    zoom_timeline(editor, ZOOM_STEP * ZOOM_STEP, gtk_widget_get_allocated_width(editor->timeline_drawing_area) / 2.0);
+}
+
+static void on_zoom_out(GtkButton *button, gpointer user_data) {
+    AudioEditor *editor = (AudioEditor *)user_data;
+    zoom_timeline(editor, 1.0 / (ZOOM_STEP * ZOOM_STEP), gtk_widget_get_allocated_width(editor->timeline_drawing_area) / 2.0);
+}
+
+/* Alterna a área dos clipes entre a waveform e o espectrograma. */
+static void on_spectrogram_toggled(GtkToggleButton *button, gpointer user_data) {
+    AudioEditor *editor = (AudioEditor *)user_data;
+    editor->show_spectrogram = gtk_toggle_button_get_active(button);
+    gtk_widget_queue_draw(editor->timeline_drawing_area);
+}
+
+/* Mostra o projeto inteiro na largura da tela. */
+static void on_zoom_fit(GtkButton *button, gpointer user_data) {
+    AudioEditor *editor = (AudioEditor *)user_data;
+    int width = gtk_widget_get_allocated_width(editor->timeline_drawing_area);
+    if (width <= 0) return;
+    
+    editor->view_start = 0;
+    zoom_timeline(editor, width / (timeline_duration(editor) / TIMELINE_UNITS_PER_SECOND) / editor->zoom_level, 0);
+}
+
 GtkWidget* create_toolbar(AudioEditor *editor) {
     GtkWidget *toolbar = gtk_box_new(GTK_ORIENTATION_HORIZONTAL, 8);
     gtk_widget_set_margin_start(toolbar, 10);
@@ -901,6 +1586,24 @@ GtkWidget* create_toolbar(AudioEditor *editor) {
     
     gtk_box_pack_start(GTK_BOX(toolbar), gtk_separator_new(GTK_ORIENTATION_VERTICAL), FALSE, FALSE, 5);
     
+    GtkWidget *zoom_in_btn = gtk_button_new_with_label("🔍 Zoom +");
+    g_signal_connect(zoom_in_btn, "clicked", G_CALLBACK(on_zoom_in), editor);
+    gtk_box_pack_start(GTK_BOX(toolbar), zoom_in_btn, FALSE, FALSE, 0);
+    
+    GtkWidget *zoom_out_btn = gtk_button_new_with_label("🔍 Zoom −");
+    g_signal_connect(zoom_out_btn, "clicked", G_CALLBACK(on_zoom_out), editor);
+    gtk_box_pack_start(GTK_BOX(toolbar), zoom_out_btn, FALSE, FALSE, 0);
+    
+    GtkWidget *zoom_fit_btn = gtk_button_new_with_label("↔️ Ajustar");
+    g_signal_connect(zoom_fit_btn, "clicked", G_CALLBACK(on_zoom_fit), editor);
+    gtk_box_pack_start(GTK_BOX(toolbar), zoom_fit_btn, FALSE, FALSE, 0);
+    
+    GtkWidget *spectrogram_btn = gtk_toggle_button_new_with_label("🌈 Espectrograma");
+    g_signal_connect(spectrogram_btn, "toggled", G_CALLBACK(on_spectrogram_toggled), editor);
+    gtk_box_pack_start(GTK_BOX(toolbar), spectrogram_btn, FALSE, FALSE, 0);
+    
+    gtk_box_pack_start(GTK_BOX(toolbar), gtk_separator_new(GTK_ORIENTATION_VERTICAL), FALSE, FALSE, 5);
+    
     GtkWidget *export_btn = gtk_button_new_with_label("💾 Exportar WAV");
     g_signal_connect(export_btn, "clicked", G_CALLBACK(on_export), editor);
     gtk_box_pack_start(GTK_BOX(toolbar), export_btn, FALSE, FALSE, 0);
@@ -908,6 +1611,10 @@ GtkWidget* create_toolbar(AudioEditor *editor) {
     return toolbar;
 }
 
+/*
+ * Mostra a taxa e o formato da sessão, que vêm do primeiro clipe: a reprodução
+ * roda na taxa dele e a exportação grava no formato de amostra dele.
+ */
 static void update_info_label(AudioEditor *editor) {
     if (!editor->transport_controls) return;
     
@@ -917,10 +1624,19 @@ static void update_info_label(AudioEditor *editor) {
     GList *iter = g_list_last(children);
     if (iter) {
         GtkWidget *info_label = GTK_WIDGET(iter->data);
-        int clip_count = g_list_length(editor->audio_clips);
+        int clip_count = editor->audio_clips.count;
         char info_text[100];
-        snprintf(info_text, sizeof(info_text), "🎵 %d Hz • 16-bit • %d arquivo(s)", 
-                 editor->sample_rate, clip_count);
+        AudioClip *first = clip_at(editor, 0);
+        WAV_Info first_info;
+        if (first && get_wav_info(first->filename, &first_info) == 0) {
+            WavSampleFormat format = wav_sample_format(&first_info);
+            if (format == WAV_SAMPLE_UNSUPPORTED) format = WAV_SAMPLE_S16;
+            snprintf(info_text, sizeof(info_text), "🎵 %u Hz • %d-bit%s • %d arquivo(s)",
+                     first_info.sample_rate, wav_sample_bytes(format) * 8,
+                     format == WAV_SAMPLE_F32 ? " float" : "", clip_count);
+        } else {
+            snprintf(info_text, sizeof(info_text), "🎵 %d arquivo(s)", clip_count);
+        }
         gtk_label_set_text(GTK_LABEL(info_label), info_text);
     }
     g_list_free(children);
@@ -943,30 +1659,106 @@ GtkWidget* create_transport_controls(AudioEditor *editor) {
     gtk_widget_set_margin_end(progress_scale, 10);
     gtk_box_pack_start(GTK_BOX(transport), progress_scale, TRUE, TRUE, 0);
     
-    GtkWidget *info_label = gtk_label_new("🎵 44100 Hz • 16-bit • 0 arquivo(s)");
+    GtkWidget *info_label = gtk_label_new("🎵 0 arquivo(s)");
     gtk_box_pack_start(GTK_BOX(transport), info_label, FALSE, FALSE, 0);
     
     return transport;
 }
 
+/*
+ * Ctrl + roda dá zoom em volta do mouse; Shift + roda (ou a roda horizontal)
+ * rola a linha do tempo. A roda sozinha fica para a rolagem vertical das faixas.
+ */
+static gboolean on_timeline_scroll(GtkWidget *widget, GdkEventScroll *event, gpointer user_data) {
+    AudioEditor *editor = (AudioEditor *)user_data;
+    
+    double delta_x = 0, delta_y = 0;
+    if (event->direction == GDK_SCROLL_SMOOTH) {
+        gdk_event_get_scroll_deltas((GdkEvent *)event, &delta_x, &delta_y);
+    } else if (event->direction == GDK_SCROLL_UP) {
+        delta_y = -1;
+    } else if (event->direction == GDK_SCROLL_DOWN) {
+        delta_y = 1;
+    } else if (event->direction == GDK_SCROLL_LEFT) {
+        delta_x = -1;
+    } else if (event->direction == GDK_SCROLL_RIGHT) {
+        delta_x = 1;
+    }
+    
+    if (event->state & GDK_CONTROL_MASK) {
+        if (delta_y == 0) return TRUE;
+        zoom_timeline(editor, pow(ZOOM_STEP, -delta_y), event->x);
+        return TRUE;
+    }
+    
+    if (event->state & GDK_SHIFT_MASK) {
+        delta_x += delta_y;
+    }
+    if (delta_x == 0) return FALSE;
+    
+    set_view(editor, editor->view_start + delta_x * SCROLL_STEP_PIXELS / editor->zoom_level);
+    return TRUE;
+}
+
+static void on_timeline_hscroll(GtkAdjustment *adjustment, gpointer user_data) {
+    AudioEditor *editor = (AudioEditor *)user_data;
+    editor->view_start = gtk_adjustment_get_value(adjustment);
+    gtk_widget_queue_draw(editor->timeline_drawing_area);
+}
+
+static void on_timeline_size_allocate(GtkWidget *widget, GdkRectangle *allocation, gpointer user_data) {
+    update_timeline_scroll((AudioEditor *)user_data);
+}
+
+/*
+ * As linhas rolam na vertical pela janela de rolagem; na horizontal a área
+ * tem a largura da janela e a barra de baixo move view_start.
+ */
 GtkWidget* create_timeline_area(AudioEditor *editor) {
+    GtkWidget *timeline_box = gtk_box_new(GTK_ORIENTATION_VERTICAL, 0);
+    
     GtkWidget *scrolled_window = gtk_scrolled_window_new(NULL, NULL);
     gtk_scrolled_window_set_policy(GTK_SCROLLED_WINDOW(scrolled_window),
-                                  GTK_POLICY_AUTOMATIC, GTK_POLICY_AUTOMATIC);
+                                  GTK_POLICY_NEVER, GTK_POLICY_AUTOMATIC);
     
     editor->timeline_drawing_area = gtk_drawing_area_new();
-    gtk_widget_set_size_request(editor->timeline_drawing_area, 800, 500);
+    gtk_widget_set_size_request(editor->timeline_drawing_area, 800, TRACK_COUNT * TRACK_HEIGHT);
     
     g_signal_connect(editor->timeline_drawing_area, "draw", 
                     G_CALLBACK(draw_timeline), editor);
     
-    gtk_widget_add_events(editor->timeline_drawing_area, GDK_BUTTON_PRESS_MASK);
+    gtk_widget_add_events(editor->timeline_drawing_area,
+                          GDK_BUTTON_PRESS_MASK | GDK_BUTTON_RELEASE_MASK | GDK_BUTTON_MOTION_MASK |
+                          GDK_SCROLL_MASK | GDK_SMOOTH_SCROLL_MASK);
     g_signal_connect(editor->timeline_drawing_area, "button-press-event",
                     G_CALLBACK(on_timeline_button_press), editor);
+    g_signal_connect(editor->timeline_drawing_area, "motion-notify-event",
+                    G_CALLBACK(on_timeline_motion), editor);
+    g_signal_connect(editor->timeline_drawing_area, "button-release-event",
+                    G_CALLBACK(on_timeline_button_release), editor);
+    g_signal_connect(editor->timeline_drawing_area, "scroll-event",
+                    G_CALLBACK(on_timeline_scroll), editor);
+    g_signal_connect(editor->timeline_drawing_area, "size-allocate",
+                    G_CALLBACK(on_timeline_size_allocate), editor);
     
     gtk_container_add(GTK_CONTAINER(scrolled_window), editor->timeline_drawing_area);
+    gtk_box_pack_start(GTK_BOX(timeline_box), scrolled_window, TRUE, TRUE, 0);
+    
+    editor->timeline_hadjustment = gtk_adjustment_new(0, 0, 10, 1, 9, 10);
+    g_signal_connect(editor->timeline_hadjustment, "value-changed",
+                    G_CALLBACK(on_timeline_hscroll), editor);
+    GtkWidget *hscrollbar = gtk_scrollbar_new(GTK_ORIENTATION_HORIZONTAL, editor->timeline_hadjustment);
+    gtk_box_pack_start(GTK_BOX(timeline_box), hscrollbar, FALSE, FALSE, 0);
     
-    return scrolled_window;
+    return timeline_box;
+}
+
+/* Durante a reprodução a mudança vai para a thread de áudio e é ouvida na hora. */
+static void send_clip_gain(AudioEditor *editor, AudioClip *clip) {
+    if (editor->playing) {
+        playback_engine_set_gain(&editor->playback, clip->index, editor->audio_clips.volume[clip->index],
+                                 editor->audio_clips.pan[clip->index]);
+    }
 }
 
 static void on_volume_changed(GtkRange *range, gpointer user_data) {
@@ -974,7 +1766,8 @@ static void on_volume_changed(GtkRange *range, gpointer user_data) {
     float volume = (float)gtk_range_get_value(range);
     
     if (editor->selected_clip) {
-        editor->selected_clip->volume = volume;
+        editor->audio_clips.volume[editor->selected_clip->index] = volume;
+        send_clip_gain(editor, editor->selected_clip);
         printf("🔊 Volume do clip selecionado ajustado para: %.1f\n", volume);
         
         if (editor->timeline_drawing_area) {
@@ -990,7 +1783,8 @@ static void on_pan_changed(GtkRange *range, gpointer user_data) {
     float pan = (float)gtk_range_get_value(range);
     
     if (editor->selected_clip) {
-        editor->selected_clip->pan = pan;
+        editor->audio_clips.pan[editor->selected_clip->index] = pan;
+        send_clip_gain(editor, editor->selected_clip);
         printf("🎚️ Pan do clip selecionado ajustado para: %.1f\n", pan);
         
         if (editor->timeline_drawing_area) {
@@ -1005,12 +1799,12 @@ static void update_mixer_controls(AudioEditor *editor) {
     if (editor->selected_clip) {
         if (editor->volume_scale) {
             g_signal_handlers_block_by_func(editor->volume_scale, on_volume_changed, editor);
-            gtk_range_set_value(GTK_RANGE(editor->volume_scale), editor->selected_clip->volume);
+            gtk_range_set_value(GTK_RANGE(editor->volume_scale), editor->audio_clips.volume[editor->selected_clip->index]);
             g_signal_handlers_unblock_by_func(editor->volume_scale, on_volume_changed, editor);
         }
         if (editor->pan_scale) {
             g_signal_handlers_block_by_func(editor->pan_scale, on_pan_changed, editor);
-            gtk_range_set_value(GTK_RANGE(editor->pan_scale), editor->selected_clip->pan);
+            gtk_range_set_value(GTK_RANGE(editor->pan_scale), editor->audio_clips.pan[editor->selected_clip->index]);
             g_signal_handlers_unblock_by_func(editor->pan_scale, on_pan_changed, editor);
         }
     } else {
@@ -1184,21 +1978,33 @@ void launch_audio_editor(int argc, char *argv[]) {
     #endif
     
     AudioEditor *editor = g_malloc0(sizeof(AudioEditor));
-    editor->sample_rate = 44100;
+    
+    /* Os picos das waveforms ficam em cache para reabrir arquivos sem reler o áudio. */
+    char *peak_cache_dir = g_build_filename(g_get_user_cache_dir(), "studio-wav", "peaks", NULL);
+    if (g_mkdir_with_parents(peak_cache_dir, 0700) != 0) {
+        printf("⚠️ Cache de waveforms desabilitado: não foi possível criar %s\n", peak_cache_dir);
+        g_free(peak_cache_dir);
+        peak_cache_dir = NULL;
+    }
+    editor->peak_builder = peak_builder_create(peak_cache_dir, on_peaks_progress, editor);
+    g_free(peak_cache_dir);
+    editor->spectrogram_engine = spectrogram_engine_create(on_peaks_progress, editor);
+    
     editor->current_position = 0;
     editor->playing = 0;
-    editor->audio_clips = NULL;
+    editor->timeline_end = 1000000;
     editor->selected_clip = NULL;
     editor->volume_scale = NULL;
     editor->pan_scale = NULL;
-    editor->zoom_level = 1.0f;
+    editor->zoom_level = ZOOM_DEFAULT;
     editor->view_start = 0;
+    g_queue_init(&editor->clip_surfaces);
     #ifdef USE_SDL2
     editor->audio_device = 0;
     #endif
-    editor->audio_buffer = NULL;
-    editor->audio_buffer_size = 0;
-    editor->audio_buffer_pos = 0;
+    editor->scrubbing = 0;
+    editor->playhead_tick = 0;
+    editor->cursor_x = -1;
     editor->audio_playing = 0;
     g_editor = editor;
     
@@ -1240,30 +2046,19 @@ void launch_audio_editor(int argc, char *argv[]) {
         SDL_PauseAudioDevice(editor->audio_device, 1);
         SDL_CloseAudioDevice(editor->audio_device);
     }
-    
-    if (editor->audio_buffer) {
-        SDL_FreeWAV((Uint8 *)editor->audio_buffer);
-    }
-    #else
-    if (editor->audio_buffer) {
-        free(editor->audio_buffer);
-    }
     #endif
+    playback_engine_stop(&editor->playback);
     
-    #ifdef _WIN32
-    remove("playback_temp.wav");
-    #else
-    remove("/tmp/playback_temp.wav");
-    #endif
-    
-    GList *iter = editor->audio_clips;
-    while (iter != NULL) {
-        AudioClip *clip = (AudioClip *)iter->data;
-        g_free(clip->filename);
-        g_free(clip);
-        iter = g_list_next(iter);
+    for (int i = 0; i < editor->audio_clips.count; i++) {
+        free_audio_clip(editor, editor->audio_clips.items[i]);
+    }
+    clip_table_free(&editor->audio_clips);
+    for (int track = 0; track < TRACK_COUNT; track++) {
+        g_free(editor->tracks[track].clips);
+        g_free(editor->tracks[track].max_end);
     }
-    g_list_free(editor->audio_clips);
+    peak_builder_destroy(editor->peak_builder);
+    spectrogram_engine_destroy(editor->spectrogram_engine);
     g_free(editor);
     
     #ifdef USE_SDL2
@@ -2,21 +2,90 @@
 #define AUDIO_EDITOR_H
 
 #include <gtk/gtk.h>
+#include "playback.h"
+#include "peaks.h"
+#include "spectrogram.h"
 
 #ifdef USE_SDL2
 #include <SDL2/SDL.h>
 #endif
 
+/* Faixas da linha do tempo; cada uma guarda quantos clipes for, um depois do outro. */
+#define TRACK_COUNT 8
+
+/*
+ * Desenho de um clipe guardado entre exposes. body tem o fundo, a borda e a
+ * waveform de um trecho do clipe (um pouco além da tela, para a rolagem não
+ * refazer tudo); label tem os textos, que acompanham a borda da tela. Cada um
+ * é refeito só quando o que está guardado junto dele muda.
+ */
+typedef struct {
+    cairo_surface_t *body;
+    double body_zoom;
+    double body_left;       /* pixel do clipe (a partir do início) na borda esquerda de body */
+    int body_width;
+    int body_track;
+    int body_index;
+    int body_selected;
+    float body_progress;
+    int body_spectrogram;
+    
+    cairo_surface_t *label;
+    float label_volume;
+    float label_pan;
+    int label_index;
+    int label_progress;
+    
+    GList *lru_link;        /* posição em AudioEditor.clip_surfaces */
+} ClipSurfaces;
+
+/*
+ * Estado de tela de um clipe. A posição, o ganho e o resto do que a mixagem e
+ * o desenho leem de todos os clipes ficam em ClipTable, no elemento index.
+ */
 typedef struct {
     char *filename;
-    float volume;
-    float pan;
-    int start_pos;
-    int duration;
-    int muted;
-    int solo;
+    PeakPyramid *peaks;     /* NULL se a waveform não pôde ser calculada; pode estar incompleta */
+    WavReader *reader;      /* arquivo mapeado, para o zoom de perto (abaixo de um pico por pixel) */
+    Spectrogram *spectrogram; /* NULL se o formato não é suportado; ladrilhos em AudioEditor.spectrogram_engine */
+    ClipSurfaces surfaces;
+    int index;              /* posição em AudioEditor.audio_clips, mantida por clip_table_remove() */
 } AudioClip;
 
+/*
+ * Tabela de clipes em ordem de importação, que é o índice na mixagem. Os
+ * campos que a mixagem e o desenho leem ficam em vetores paralelos, um
+ * elemento por clipe; items guarda o resto (arquivo, picos, desenho).
+ * start_pos e duration estão em 1/100000 s; track é a faixa, escolhida ao
+ * importar.
+ */
+typedef struct {
+    int count;
+    int capacity;
+    int64_t *start_pos;
+    int64_t *duration;
+    float *volume;
+    float *pan;
+    uint8_t *muted;
+    uint8_t *solo;
+    int *track;
+    AudioClip **items;
+} ClipTable;
+
+/*
+ * Índice de intervalos de uma faixa, refeito por update_clip_layout(): os
+ * clipes da faixa (posições em AudioEditor.audio_clips) em ordem de start_pos
+ * e, em max_end[i], o maior fim entre clips[0] e clips[i]. Como max_end só
+ * cresce, uma busca binária acha o primeiro clipe que pode cobrir um instante.
+ */
+typedef struct {
+    int *clips;
+    int64_t *max_end;
+    int count;
+    int capacity;
+    int64_t end;            /* fim do último clipe; o próximo clipe da faixa começa aqui */
+} ClipTrack;
+
 typedef struct {
     GtkWidget *window;
     GtkWidget *main_box;
@@ -26,27 +95,49 @@ typedef struct {
     GtkWidget *status_bar;
     GtkWidget *mixer_panel;
     
-    GList *audio_clips;
+    ClipTable audio_clips;
+    ClipTrack tracks[TRACK_COUNT];
+    int64_t timeline_end;   /* fim do último clipe (no mínimo 10 s), em 1/100000 s */
     AudioClip *selected_clip;
     GtkWidget *volume_scale;
     GtkWidget *pan_scale;
-    int sample_rate;
-    int current_position;
+    int64_t current_position;
     int playing;
     
     GtkWidget *timeline_drawing_area;
     
-    float zoom_level;
-    int view_start;
+    float zoom_level;       /* pixels por segundo */
+    double view_start;      /* segundo da linha do tempo na borda esquerda */
+    GtkAdjustment *timeline_hadjustment;
+    
+    /* Clipes com desenho guardado, o usado mais recentemente na frente. */
+    GQueue clip_surfaces;
     #ifdef USE_SDL2
     SDL_AudioDeviceID audio_device;
     SDL_AudioSpec audio_spec;
     #endif
-    int16_t *audio_buffer;
-    size_t audio_buffer_size;
-    size_t audio_buffer_pos;
+    PlaybackEngine playback;
+    int scrubbing;
     int audio_playing;
     
+    /*
+     * Relógio de amostras: quadro entregue no último callback, de qual seek
+     * (PlaybackEngine.seek_generation) e quando (g_get_monotonic_time).
+     */
+    _Atomic uint64_t clock_frame;
+    _Atomic uint32_t clock_generation;
+    _Atomic gint64 clock_time;
+    guint playhead_tick;
+    int cursor_x;
+    
+    /* Threads que calculam as waveforms; pedem redesenho por peaks_redraw_pending. */
+    PeakBuilder *peak_builder;
+    _Atomic int peaks_redraw_pending;
+    
+    /* Ladrilhos do espectrograma, mostrado no lugar da waveform com show_spectrogram. */
+    SpectrogramEngine *spectrogram_engine;
+    int show_spectrogram;
+    
 } AudioEditor;
 
 void launch_audio_editor(int argc, char *argv[]);
@@ -0,0 +1,1218 @@
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include <float.h>
+#include <pthread.h>
+#include "mix_kernels.h"
+
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#define MIX_KERNELS_X86 1
+#include <immintrin.h>
+#endif
+
+/*
+ * Escalas entre os formatos de arquivo e o barramento (escala de 16 bits):
+ * 8 bits sem sinal é deslocado de 128 e multiplicado por 256; 24 e 32 bits
+ * são lidos como inteiro de 32 bits alinhado à esquerda e divididos por 65536;
+ * float vai de [-1, 1] para [-32768, 32768].
+ */
+#define S32_TO_BUS (1.0f / 65536.0f)
+#define BUS_TO_F32 (1.0f / 32768.0f)
+#define S32_MAX_FLOAT 2147483520.0f
+#define S32_MIN_FLOAT -2147483648.0f
+
+/* ---------- escalar ---------- */
+
+static void s16_to_float_scalar(float* dst, const int16_t* src, size_t count) {
+    for (size_t i = 0; i < count; i++) {
+        dst[i] = (float)src[i];
+    }
+}
+
+static void float_to_s16_scalar(int16_t* dst, const float* src, size_t count) {
+    for (size_t i = 0; i < count; i++) {
+        float value = src[i];
+        if (value > 32767.0f) value = 32767.0f;
+        if (value < -32768.0f) value = -32768.0f;
+        dst[i] = (int16_t)value;
+    }
+}
+
+static void u8_to_float_scalar(float* dst, const void* src, size_t count) {
+    const uint8_t* in = (const uint8_t*)src;
+    for (size_t i = 0; i < count; i++) {
+        dst[i] = (float)((int)in[i] - 128) * 256.0f;
+    }
+}
+
+static void s16v_to_float_scalar(float* dst, const void* src, size_t count) {
+    s16_to_float_scalar(dst, (const int16_t*)src, count);
+}
+
+static void s24_to_float_scalar(float* dst, const void* src, size_t count) {
+    const uint8_t* in = (const uint8_t*)src;
+    for (size_t i = 0; i < count; i++) {
+        int32_t value = (int32_t)((uint32_t)in[i * 3] << 8 | (uint32_t)in[i * 3 + 1] << 16 |
+                                  (uint32_t)in[i * 3 + 2] << 24);
+        dst[i] = (float)value * S32_TO_BUS;
+    }
+}
+
+static void s32_to_float_scalar(float* dst, const void* src, size_t count) {
+    const uint8_t* in = (const uint8_t*)src;
+    for (size_t i = 0; i < count; i++) {
+        int32_t value;
+        memcpy(&value, in + i * 4, 4);
+        dst[i] = (float)value * S32_TO_BUS;
+    }
+}
+
+static void f32_to_float_scalar(float* dst, const void* src, size_t count) {
+    const uint8_t* in = (const uint8_t*)src;
+    for (size_t i = 0; i < count; i++) {
+        float value;
+        memcpy(&value, in + i * 4, 4);
+        dst[i] = value * 32768.0f;
+    }
+}
+
+static void float_to_u8_scalar(void* dst, const float* src, size_t count) {
+    uint8_t* out = (uint8_t*)dst;
+    for (size_t i = 0; i < count; i++) {
+        float value = src[i] * (1.0f / 256.0f);
+        if (value > 127.0f) value = 127.0f;
+        if (value < -128.0f) value = -128.0f;
+        out[i] = (uint8_t)((int)value + 128);
+    }
+}
+
+static void float_to_s16v_scalar(void* dst, const float* src, size_t count) {
+    float_to_s16_scalar((int16_t*)dst, src, count);
+}
+
+static void float_to_s24_scalar(void* dst, const float* src, size_t count) {
+    uint8_t* out = (uint8_t*)dst;
+    for (size_t i = 0; i < count; i++) {
+        float value = src[i] * 256.0f;
+        if (value > 8388607.0f) value = 8388607.0f;
+        if (value < -8388608.0f) value = -8388608.0f;
+        int32_t sample = (int32_t)value;
+        out[i * 3] = (uint8_t)sample;
+        out[i * 3 + 1] = (uint8_t)(sample >> 8);
+        out[i * 3 + 2] = (uint8_t)(sample >> 16);
+    }
+}
+
+static void float_to_s32_scalar(void* dst, const float* src, size_t count) {
+    uint8_t* out = (uint8_t*)dst;
+    for (size_t i = 0; i < count; i++) {
+        float value = src[i] * 65536.0f;
+        if (value > S32_MAX_FLOAT) value = S32_MAX_FLOAT;
+        if (value < S32_MIN_FLOAT) value = S32_MIN_FLOAT;
+        int32_t sample = (int32_t)value;
+        memcpy(out + i * 4, &sample, 4);
+    }
+}
+
+static void float_to_f32_scalar(void* dst, const float* src, size_t count) {
+    uint8_t* out = (uint8_t*)dst;
+    for (size_t i = 0; i < count; i++) {
+        float value = src[i] * BUS_TO_F32;
+        memcpy(out + i * 4, &value, 4);
+    }
+}
+
+static void mix_stereo_s16_scalar(float* bus, const int16_t* src, size_t frames, float left_gain, float right_gain) {
+    for (size_t j = 0; j < frames; j++) {
+        bus[j * 2] += src[j * 2] * left_gain;
+        bus[j * 2 + 1] += src[j * 2 + 1] * right_gain;
+    }
+}
+
+static void mix_mono_s16_scalar(float* bus, const int16_t* src, size_t frames, float left_gain, float right_gain) {
+    for (size_t j = 0; j < frames; j++) {
+        bus[j * 2] += src[j] * left_gain;
+        bus[j * 2 + 1] += src[j] * right_gain;
+    }
+}
+
+static void mix_stereo_f32_scalar(float* bus, const float* src, size_t frames, float left_gain, float right_gain) {
+    for (size_t j = 0; j < frames; j++) {
+        bus[j * 2] += src[j * 2] * left_gain;
+        bus[j * 2 + 1] += src[j * 2 + 1] * right_gain;
+    }
+}
+
+static void mix_mono_f32_scalar(float* bus, const float* src, size_t frames, float left_gain, float right_gain) {
+    for (size_t j = 0; j < frames; j++) {
+        bus[j * 2] += src[j] * left_gain;
+        bus[j * 2 + 1] += src[j] * right_gain;
+    }
+}
+
+static float dot_f32_scalar(const float* a, const float* b, size_t count) {
+    float sum = 0.0f;
+    for (size_t i = 0; i < count; i++) {
+        sum += a[i] * b[i];
+    }
+    return sum;
+}
+
+static void mix_matrix_f32_scalar(float* bus, size_t bus_channels, const float* src, size_t src_channels,
+                                  size_t frames, const float* matrix) {
+    for (size_t j = 0; j < frames; j++) {
+        const float* in = src + j * src_channels;
+        float* out = bus + j * bus_channels;
+        for (size_t i = 0; i < src_channels; i++) {
+            const float* column = matrix + i * bus_channels;
+            for (size_t o = 0; o < bus_channels; o++) {
+                out[o] += in[i] * column[o];
+            }
+        }
+    }
+}
+
+static void peak_stats_f32_scalar(const float* src, size_t frames, size_t stride, size_t channels,
+                                  float* min, float* max, float* squares) {
+    for (size_t c = 0; c < channels; c++) {
+        for (size_t j = 0; j < frames; j++) {
+            float value = src[j * stride + c];
+            if (value < min[c]) min[c] = value;
+            if (value > max[c]) max[c] = value;
+            squares[c] += value * value;
+        }
+    }
+}
+
+static void fft_stage_f32_scalar(float* re, float* im, size_t size, size_t half, const float* w_re, const float* w_im) {
+    for (size_t group = 0; group < size; group += 2 * half) {
+        float* ar = re + group;
+        float* ai = im + group;
+        float* br = ar + half;
+        float* bi = ai + half;
+        for (size_t j = 0; j < half; j++) {
+            float tr = br[j] * w_re[j] - bi[j] * w_im[j];
+            float ti = br[j] * w_im[j] + bi[j] * w_re[j];
+            br[j] = ar[j] - tr;
+            bi[j] = ai[j] - ti;
+            ar[j] += tr;
+            ai[j] += ti;
+        }
+    }
+}
+
+static const MixKernels kernels_scalar = {
+    MIX_SIMD_SCALAR, "scalar",
+    s16_to_float_scalar, float_to_s16_scalar, mix_stereo_s16_scalar, mix_mono_s16_scalar,
+    { NULL, u8_to_float_scalar, s16v_to_float_scalar, s24_to_float_scalar, s32_to_float_scalar, f32_to_float_scalar },
+    { NULL, float_to_u8_scalar, float_to_s16v_scalar, float_to_s24_scalar, float_to_s32_scalar, float_to_f32_scalar },
+    mix_stereo_f32_scalar, mix_mono_f32_scalar, dot_f32_scalar, mix_matrix_f32_scalar,
+    peak_stats_f32_scalar, fft_stage_f32_scalar
+};
+
+#ifdef MIX_KERNELS_X86
+
+/* ---------- SSE2: 4 floats / 8 amostras de 16 bits por iteração ---------- */
+
+__attribute__((target("sse2")))
+static inline void s16x8_to_ps_sse2(__m128i v, __m128* lo, __m128* hi) {
+    *lo = _mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpacklo_epi16(v, v), 16));
+    *hi = _mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpackhi_epi16(v, v), 16));
+}
+
+__attribute__((target("sse2")))
+static void s16_to_float_sse2(float* dst, const int16_t* src, size_t count) {
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m128 lo, hi;
+        s16x8_to_ps_sse2(_mm_loadu_si128((const __m128i*)(src + i)), &lo, &hi);
+        _mm_storeu_ps(dst + i, lo);
+        _mm_storeu_ps(dst + i + 4, hi);
+    }
+    s16_to_float_scalar(dst + i, src + i, count - i);
+}
+
+__attribute__((target("sse2")))
+static void float_to_s16_sse2(int16_t* dst, const float* src, size_t count) {
+    const __m128 max_value = _mm_set1_ps(32767.0f);
+    const __m128 min_value = _mm_set1_ps(-32768.0f);
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m128 a = _mm_max_ps(_mm_min_ps(_mm_loadu_ps(src + i), max_value), min_value);
+        __m128 b = _mm_max_ps(_mm_min_ps(_mm_loadu_ps(src + i + 4), max_value), min_value);
+        __m128i packed = _mm_packs_epi32(_mm_cvttps_epi32(a), _mm_cvttps_epi32(b));
+        _mm_storeu_si128((__m128i*)(dst + i), packed);
+    }
+    float_to_s16_scalar(dst + i, src + i, count - i);
+}
+
+__attribute__((target("sse2")))
+static void s16v_to_float_sse2(float* dst, const void* src, size_t count) {
+    s16_to_float_sse2(dst, (const int16_t*)src, count);
+}
+
+__attribute__((target("sse2")))
+static void float_to_s16v_sse2(void* dst, const float* src, size_t count) {
+    float_to_s16_sse2((int16_t*)dst, src, count);
+}
+
+__attribute__((target("sse2")))
+static void u8_to_float_sse2(float* dst, const void* src, size_t count) {
+    const uint8_t* in = (const uint8_t*)src;
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i bias = _mm_set1_epi16(128);
+    const __m128 scale = _mm_set1_ps(256.0f);
+    size_t i = 0;
+    for (; i + 16 <= count; i += 16) {
+        __m128i bytes = _mm_loadu_si128((const __m128i*)(in + i));
+        __m128i words[2] = {
+            _mm_sub_epi16(_mm_unpacklo_epi8(bytes, zero), bias),
+            _mm_sub_epi16(_mm_unpackhi_epi8(bytes, zero), bias)
+        };
+        for (int h = 0; h < 2; h++) {
+            __m128 lo, hi;
+            s16x8_to_ps_sse2(words[h], &lo, &hi);
+            _mm_storeu_ps(dst + i + h * 8, _mm_mul_ps(lo, scale));
+            _mm_storeu_ps(dst + i + h * 8 + 4, _mm_mul_ps(hi, scale));
+        }
+    }
+    u8_to_float_scalar(dst + i, in + i, count - i);
+}
+
+__attribute__((target("sse2")))
+static void float_to_u8_sse2(void* dst, const float* src, size_t count) {
+    uint8_t* out = (uint8_t*)dst;
+    const __m128 scale = _mm_set1_ps(1.0f / 256.0f);
+    const __m128 max_value = _mm_set1_ps(127.0f);
+    const __m128 min_value = _mm_set1_ps(-128.0f);
+    const __m128i bias = _mm_set1_epi16(128);
+    size_t i = 0;
+    for (; i + 16 <= count; i += 16) {
+        __m128i ints[4];
+        for (int q = 0; q < 4; q++) {
+            __m128 v = _mm_mul_ps(_mm_loadu_ps(src + i + q * 4), scale);
+            ints[q] = _mm_cvttps_epi32(_mm_max_ps(_mm_min_ps(v, max_value), min_value));
+        }
+        __m128i lo = _mm_add_epi16(_mm_packs_epi32(ints[0], ints[1]), bias);
+        __m128i hi = _mm_add_epi16(_mm_packs_epi32(ints[2], ints[3]), bias);
+        _mm_storeu_si128((__m128i*)(out + i), _mm_packus_epi16(lo, hi));
+    }
+    float_to_u8_scalar(out + i, src + i, count - i);
+}
+
+__attribute__((target("sse2")))
+static void s32_to_float_sse2(float* dst, const void* src, size_t count) {
+    const int32_t* in = (const int32_t*)src;
+    const __m128 scale = _mm_set1_ps(S32_TO_BUS);
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        __m128 v = _mm_cvtepi32_ps(_mm_loadu_si128((const __m128i*)(in + i)));
+        _mm_storeu_ps(dst + i, _mm_mul_ps(v, scale));
+    }
+    s32_to_float_scalar(dst + i, in + i, count - i);
+}
+
+__attribute__((target("sse2")))
+static void float_to_s32_sse2(void* dst, const float* src, size_t count) {
+    int32_t* out = (int32_t*)dst;
+    const __m128 scale = _mm_set1_ps(65536.0f);
+    const __m128 max_value = _mm_set1_ps(S32_MAX_FLOAT);
+    const __m128 min_value = _mm_set1_ps(S32_MIN_FLOAT);
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        __m128 v = _mm_mul_ps(_mm_loadu_ps(src + i), scale);
+        v = _mm_max_ps(_mm_min_ps(v, max_value), min_value);
+        _mm_storeu_si128((__m128i*)(out + i), _mm_cvttps_epi32(v));
+    }
+    float_to_s32_scalar(out + i, src + i, count - i);
+}
+
+__attribute__((target("sse2")))
+static void f32_to_float_sse2(float* dst, const void* src, size_t count) {
+    const float* in = (const float*)src;
+    const __m128 scale = _mm_set1_ps(32768.0f);
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        _mm_storeu_ps(dst + i, _mm_mul_ps(_mm_loadu_ps(in + i), scale));
+    }
+    f32_to_float_scalar(dst + i, in + i, count - i);
+}
+
+__attribute__((target("sse2")))
+static void float_to_f32_sse2(void* dst, const float* src, size_t count) {
+    float* out = (float*)dst;
+    const __m128 scale = _mm_set1_ps(BUS_TO_F32);
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        _mm_storeu_ps(out + i, _mm_mul_ps(_mm_loadu_ps(src + i), scale));
+    }
+    float_to_f32_scalar(out + i, src + i, count - i);
+}
+
+__attribute__((target("sse2")))
+static void mix_stereo_s16_sse2(float* bus, const int16_t* src, size_t frames, float left_gain, float right_gain) {
+    const __m128 gains = _mm_setr_ps(left_gain, right_gain, left_gain, right_gain);
+    size_t j = 0;
+    for (; j + 4 <= frames; j += 4) {
+        __m128 lo, hi;
+        s16x8_to_ps_sse2(_mm_loadu_si128((const __m128i*)(src + j * 2)), &lo, &hi);
+        _mm_storeu_ps(bus + j * 2, _mm_add_ps(_mm_loadu_ps(bus + j * 2), _mm_mul_ps(lo, gains)));
+        _mm_storeu_ps(bus + j * 2 + 4, _mm_add_ps(_mm_loadu_ps(bus + j * 2 + 4), _mm_mul_ps(hi, gains)));
+    }
+    mix_stereo_s16_scalar(bus + j * 2, src + j * 2, frames - j, left_gain, right_gain);
+}
+
+__attribute__((target("sse2")))
+static void mix_mono_s16_sse2(float* bus, const int16_t* src, size_t frames, float left_gain, float right_gain) {
+    const __m128 lg = _mm_set1_ps(left_gain);
+    const __m128 rg = _mm_set1_ps(right_gain);
+    size_t j = 0;
+    for (; j + 8 <= frames; j += 8) {
+        __m128 halves[2];
+        s16x8_to_ps_sse2(_mm_loadu_si128((const __m128i*)(src + j)), &halves[0], &halves[1]);
+        for (int h = 0; h < 2; h++) {
+            __m128 l = _mm_mul_ps(halves[h], lg);
+            __m128 r = _mm_mul_ps(halves[h], rg);
+            float* out = bus + (j + h * 4) * 2;
+            _mm_storeu_ps(out, _mm_add_ps(_mm_loadu_ps(out), _mm_unpacklo_ps(l, r)));
+            _mm_storeu_ps(out + 4, _mm_add_ps(_mm_loadu_ps(out + 4), _mm_unpackhi_ps(l, r)));
+        }
+    }
+    mix_mono_s16_scalar(bus + j * 2, src + j, frames - j, left_gain, right_gain);
+}
+
+__attribute__((target("sse2")))
+static void mix_stereo_f32_sse2(float* bus, const float* src, size_t frames, float left_gain, float right_gain) {
+    const __m128 gains = _mm_setr_ps(left_gain, right_gain, left_gain, right_gain);
+    size_t j = 0;
+    for (; j + 2 <= frames; j += 2) {
+        __m128 v = _mm_mul_ps(_mm_loadu_ps(src + j * 2), gains);
+        _mm_storeu_ps(bus + j * 2, _mm_add_ps(_mm_loadu_ps(bus + j * 2), v));
+    }
+    mix_stereo_f32_scalar(bus + j * 2, src + j * 2, frames - j, left_gain, right_gain);
+}
+
+__attribute__((target("sse2")))
+static void mix_mono_f32_sse2(float* bus, const float* src, size_t frames, float left_gain, float right_gain) {
+    const __m128 lg = _mm_set1_ps(left_gain);
+    const __m128 rg = _mm_set1_ps(right_gain);
+    size_t j = 0;
+    for (; j + 4 <= frames; j += 4) {
+        __m128 v = _mm_loadu_ps(src + j);
+        __m128 l = _mm_mul_ps(v, lg);
+        __m128 r = _mm_mul_ps(v, rg);
+        float* out = bus + j * 2;
+        _mm_storeu_ps(out, _mm_add_ps(_mm_loadu_ps(out), _mm_unpacklo_ps(l, r)));
+        _mm_storeu_ps(out + 4, _mm_add_ps(_mm_loadu_ps(out + 4), _mm_unpackhi_ps(l, r)));
+    }
+    mix_mono_f32_scalar(bus + j * 2, src + j, frames - j, left_gain, right_gain);
+}
+
+__attribute__((target("sse2")))
+static float dot_f32_sse2(const float* a, const float* b, size_t count) {
+    __m128 acc = _mm_setzero_ps();
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        acc = _mm_add_ps(acc, _mm_mul_ps(_mm_loadu_ps(a + i), _mm_loadu_ps(b + i)));
+    }
+    acc = _mm_add_ps(acc, _mm_movehl_ps(acc, acc));
+    acc = _mm_add_ss(acc, _mm_shuffle_ps(acc, acc, 1));
+    return _mm_cvtss_f32(acc) + dot_f32_scalar(a + i, b + i, count - i);
+}
+
+/* Vetoriza sobre os canais do barramento, 4 por vez; o resto de cada quadro fica no escalar. */
+__attribute__((target("sse2")))
+static void mix_matrix_f32_sse2(float* bus, size_t bus_channels, const float* src, size_t src_channels,
+                                size_t frames, const float* matrix) {
+    for (size_t j = 0; j < frames; j++) {
+        const float* in = src + j * src_channels;
+        float* out = bus + j * bus_channels;
+        size_t o = 0;
+        for (; o + 4 <= bus_channels; o += 4) {
+            __m128 acc = _mm_loadu_ps(out + o);
+            for (size_t i = 0; i < src_channels; i++) {
+                acc = _mm_add_ps(acc, _mm_mul_ps(_mm_set1_ps(in[i]), _mm_loadu_ps(matrix + i * bus_channels + o)));
+            }
+            _mm_storeu_ps(out + o, acc);
+        }
+        for (; o < bus_channels; o++) {
+            for (size_t i = 0; i < src_channels; i++) {
+                out[o] += in[i] * matrix[i * bus_channels + o];
+            }
+        }
+    }
+}
+
+/*
+ * Junta as faixas dos acumuladores de peak_stats_f32 em min/max/squares. Em
+ * estéreo as faixas pares são do canal 0 e as ímpares do 1; em mono, todas do 0.
+ */
+__attribute__((target("sse2")))
+static inline void peak_stats_store_sse2(__m128 low, __m128 high, __m128 sum, size_t channels,
+                                         float* min, float* max, float* squares) {
+    low = _mm_min_ps(low, _mm_movehl_ps(low, low));
+    high = _mm_max_ps(high, _mm_movehl_ps(high, high));
+    sum = _mm_add_ps(sum, _mm_movehl_ps(sum, sum));
+    if (channels == 1) {
+        low = _mm_min_ss(low, _mm_shuffle_ps(low, low, 1));
+        high = _mm_max_ss(high, _mm_shuffle_ps(high, high, 1));
+        sum = _mm_add_ss(sum, _mm_shuffle_ps(sum, sum, 1));
+    }
+
+    float lanes[3][4];
+    _mm_storeu_ps(lanes[0], low);
+    _mm_storeu_ps(lanes[1], high);
+    _mm_storeu_ps(lanes[2], sum);
+    for (size_t c = 0; c < channels; c++) {
+        if (lanes[0][c] < min[c]) min[c] = lanes[0][c];
+        if (lanes[1][c] > max[c]) max[c] = lanes[1][c];
+        squares[c] += lanes[2][c];
+    }
+}
+
+/* Só mono e estéreo sem outros canais no meio são vetorizados; o resto fica no escalar. */
+__attribute__((target("sse2")))
+static void peak_stats_f32_sse2(const float* src, size_t frames, size_t stride, size_t channels,
+                                float* min, float* max, float* squares) {
+    if (stride != channels || channels > 2) {
+        peak_stats_f32_scalar(src, frames, stride, channels, min, max, squares);
+        return;
+    }
+
+    __m128 low = _mm_set1_ps(FLT_MAX);
+    __m128 high = _mm_set1_ps(-FLT_MAX);
+    __m128 sum = _mm_setzero_ps();
+    size_t count = frames * channels;
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        __m128 v = _mm_loadu_ps(src + i);
+        low = _mm_min_ps(low, v);
+        high = _mm_max_ps(high, v);
+        sum = _mm_add_ps(sum, _mm_mul_ps(v, v));
+    }
+    peak_stats_store_sse2(low, high, sum, channels, min, max, squares);
+    peak_stats_f32_scalar(src + i, frames - i / channels, stride, channels, min, max, squares);
+}
+
+/* Os estágios com metades menores que um registrador ficam no escalar. */
+__attribute__((target("sse2")))
+static void fft_stage_f32_sse2(float* re, float* im, size_t size, size_t half, const float* w_re, const float* w_im) {
+    if (half < 4) {
+        fft_stage_f32_scalar(re, im, size, half, w_re, w_im);
+        return;
+    }
+
+    for (size_t group = 0; group < size; group += 2 * half) {
+        float* ar = re + group;
+        float* ai = im + group;
+        float* br = ar + half;
+        float* bi = ai + half;
+        for (size_t j = 0; j < half; j += 4) {
+            __m128 wr = _mm_loadu_ps(w_re + j);
+            __m128 wi = _mm_loadu_ps(w_im + j);
+            __m128 xr = _mm_loadu_ps(br + j);
+            __m128 xi = _mm_loadu_ps(bi + j);
+            __m128 tr = _mm_sub_ps(_mm_mul_ps(xr, wr), _mm_mul_ps(xi, wi));
+            __m128 ti = _mm_add_ps(_mm_mul_ps(xr, wi), _mm_mul_ps(xi, wr));
+            __m128 yr = _mm_loadu_ps(ar + j);
+            __m128 yi = _mm_loadu_ps(ai + j);
+            _mm_storeu_ps(br + j, _mm_sub_ps(yr, tr));
+            _mm_storeu_ps(bi + j, _mm_sub_ps(yi, ti));
+            _mm_storeu_ps(ar + j, _mm_add_ps(yr, tr));
+            _mm_storeu_ps(ai + j, _mm_add_ps(yi, ti));
+        }
+    }
+}
+
+/* SSE2 não tem embaralhamento de bytes (pshufb); 24 bits fica no escalar. */
+static const MixKernels kernels_sse2 = {
+    MIX_SIMD_SSE2, "sse2",
+    s16_to_float_sse2, float_to_s16_sse2, mix_stereo_s16_sse2, mix_mono_s16_sse2,
+    { NULL, u8_to_float_sse2, s16v_to_float_sse2, s24_to_float_scalar, s32_to_float_sse2, f32_to_float_sse2 },
+    { NULL, float_to_u8_sse2, float_to_s16v_sse2, float_to_s24_scalar, float_to_s32_sse2, float_to_f32_sse2 },
+    mix_stereo_f32_sse2, mix_mono_f32_sse2, dot_f32_sse2, mix_matrix_f32_sse2,
+    peak_stats_f32_sse2, fft_stage_f32_sse2
+};
+
+/* ---------- AVX2: 8 floats por registrador ---------- */
+
+__attribute__((target("avx2")))
+static inline __m256 s16x8_to_ps_avx2(const int16_t* src) {
+    return _mm256_cvtepi32_ps(_mm256_cvtepi16_epi32(_mm_loadu_si128((const __m128i*)src)));
+}
+
+__attribute__((target("avx2")))
+static inline __m256i ps_to_s16x16_avx2(__m256 a, __m256 b) {
+    const __m256 max_value = _mm256_set1_ps(32767.0f);
+    const __m256 min_value = _mm256_set1_ps(-32768.0f);
+    a = _mm256_max_ps(_mm256_min_ps(a, max_value), min_value);
+    b = _mm256_max_ps(_mm256_min_ps(b, max_value), min_value);
+    __m256i packed = _mm256_packs_epi32(_mm256_cvttps_epi32(a), _mm256_cvttps_epi32(b));
+    /* packs trabalha por metade de 128 bits; reordena para a ordem original */
+    return _mm256_permute4x64_epi64(packed, 0xD8);
+}
+
+__attribute__((target("avx2")))
+static void s16_to_float_avx2(float* dst, const int16_t* src, size_t count) {
+    size_t i = 0;
+    for (; i + 16 <= count; i += 16) {
+        _mm256_storeu_ps(dst + i, s16x8_to_ps_avx2(src + i));
+        _mm256_storeu_ps(dst + i + 8, s16x8_to_ps_avx2(src + i + 8));
+    }
+    s16_to_float_scalar(dst + i, src + i, count - i);
+}
+
+__attribute__((target("avx2")))
+static void float_to_s16_avx2(int16_t* dst, const float* src, size_t count) {
+    size_t i = 0;
+    for (; i + 16 <= count; i += 16) {
+        __m256i packed = ps_to_s16x16_avx2(_mm256_loadu_ps(src + i), _mm256_loadu_ps(src + i + 8));
+        _mm256_storeu_si256((__m256i*)(dst + i), packed);
+    }
+    float_to_s16_scalar(dst + i, src + i, count - i);
+}
+
+__attribute__((target("avx2")))
+static void s16v_to_float_avx2(float* dst, const void* src, size_t count) {
+    s16_to_float_avx2(dst, (const int16_t*)src, count);
+}
+
+__attribute__((target("avx2")))
+static void float_to_s16v_avx2(void* dst, const float* src, size_t count) {
+    float_to_s16_avx2((int16_t*)dst, src, count);
+}
+
+__attribute__((target("avx2")))
+static void u8_to_float_avx2(float* dst, const void* src, size_t count) {
+    const uint8_t* in = (const uint8_t*)src;
+    const __m256i bias = _mm256_set1_epi32(128);
+    const __m256 scale = _mm256_set1_ps(256.0f);
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m256i v = _mm256_cvtepu8_epi32(_mm_loadl_epi64((const __m128i*)(in + i)));
+        _mm256_storeu_ps(dst + i, _mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_sub_epi32(v, bias)), scale));
+    }
+    u8_to_float_scalar(dst + i, in + i, count - i);
+}
+
+__attribute__((target("avx2")))
+static void float_to_u8_avx2(void* dst, const float* src, size_t count) {
+    uint8_t* out = (uint8_t*)dst;
+    const __m256 scale = _mm256_set1_ps(1.0f / 256.0f);
+    const __m256i bias = _mm256_set1_epi16(128);
+    size_t i = 0;
+    for (; i + 16 <= count; i += 16) {
+        __m256 a = _mm256_mul_ps(_mm256_loadu_ps(src + i), scale);
+        __m256 b = _mm256_mul_ps(_mm256_loadu_ps(src + i + 8), scale);
+        __m256i words = _mm256_add_epi16(ps_to_s16x16_avx2(a, b), bias);
+        /* valores já estão em [0, 255]; packus junta as duas metades nos 16 bytes baixos */
+        __m256i bytes = _mm256_permute4x64_epi64(_mm256_packus_epi16(words, words), 0x08);
+        _mm_storeu_si128((__m128i*)(out + i), _mm256_castsi256_si128(bytes));
+    }
+    float_to_u8_scalar(out + i, src + i, count - i);
+}
+
+/* Cada grupo de 3 bytes vai para os 3 bytes altos de um inteiro de 32 bits. */
+__attribute__((target("avx2")))
+static void s24_to_float_avx2(float* dst, const void* src, size_t count) {
+    const uint8_t* in = (const uint8_t*)src;
+    const __m256i shuffle = _mm256_setr_epi8(
+        -1, 0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11,
+        -1, 0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11);
+    const __m256 scale = _mm256_set1_ps(S32_TO_BUS);
+    size_t i = 0;
+    /* cada iteração lê 28 bytes para 8 amostras (24 bytes); a folga evita ler além do fim */
+    for (; i + 10 <= count; i += 8) {
+        __m128i lo = _mm_loadu_si128((const __m128i*)(in + i * 3));
+        __m128i hi = _mm_loadu_si128((const __m128i*)(in + i * 3 + 12));
+        __m256i v = _mm256_inserti128_si256(_mm256_castsi128_si256(lo), hi, 1);
+        v = _mm256_shuffle_epi8(v, shuffle);
+        _mm256_storeu_ps(dst + i, _mm256_mul_ps(_mm256_cvtepi32_ps(v), scale));
+    }
+    s24_to_float_scalar(dst + i, in + i * 3, count - i);
+}
+
+__attribute__((target("avx2")))
+static void float_to_s24_avx2(void* dst, const float* src, size_t count) {
+    uint8_t* out = (uint8_t*)dst;
+    const __m256 scale = _mm256_set1_ps(256.0f);
+    const __m256 max_value = _mm256_set1_ps(8388607.0f);
+    const __m256 min_value = _mm256_set1_ps(-8388608.0f);
+    const __m256i shuffle = _mm256_setr_epi8(
+        0, 1, 2, 4, 5, 6, 8, 9, 10, 12, 13, 14, -1, -1, -1, -1,
+        0, 1, 2, 4, 5, 6, 8, 9, 10, 12, 13, 14, -1, -1, -1, -1);
+    size_t i = 0;
+    /* cada metade grava 16 bytes, 12 válidos; a próxima gravação cobre os 4 excedentes */
+    for (; i + 10 <= count; i += 8) {
+        __m256 v = _mm256_mul_ps(_mm256_loadu_ps(src + i), scale);
+        v = _mm256_max_ps(_mm256_min_ps(v, max_value), min_value);
+        __m256i packed = _mm256_shuffle_epi8(_mm256_cvttps_epi32(v), shuffle);
+        _mm_storeu_si128((__m128i*)(out + i * 3), _mm256_castsi256_si128(packed));
+        _mm_storeu_si128((__m128i*)(out + i * 3 + 12), _mm256_extracti128_si256(packed, 1));
+    }
+    float_to_s24_scalar(out + i * 3, src + i, count - i);
+}
+
+__attribute__((target("avx2")))
+static void s32_to_float_avx2(float* dst, const void* src, size_t count) {
+    const int32_t* in = (const int32_t*)src;
+    const __m256 scale = _mm256_set1_ps(S32_TO_BUS);
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m256 v = _mm256_cvtepi32_ps(_mm256_loadu_si256((const __m256i*)(in + i)));
+        _mm256_storeu_ps(dst + i, _mm256_mul_ps(v, scale));
+    }
+    s32_to_float_scalar(dst + i, in + i, count - i);
+}
+
+__attribute__((target("avx2")))
+static void float_to_s32_avx2(void* dst, const float* src, size_t count) {
+    int32_t* out = (int32_t*)dst;
+    const __m256 scale = _mm256_set1_ps(65536.0f);
+    const __m256 max_value = _mm256_set1_ps(S32_MAX_FLOAT);
+    const __m256 min_value = _mm256_set1_ps(S32_MIN_FLOAT);
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m256 v = _mm256_mul_ps(_mm256_loadu_ps(src + i), scale);
+        v = _mm256_max_ps(_mm256_min_ps(v, max_value), min_value);
+        _mm256_storeu_si256((__m256i*)(out + i), _mm256_cvttps_epi32(v));
+    }
+    float_to_s32_scalar(out + i, src + i, count - i);
+}
+
+__attribute__((target("avx2")))
+static void f32_to_float_avx2(float* dst, const void* src, size_t count) {
+    const float* in = (const float*)src;
+    const __m256 scale = _mm256_set1_ps(32768.0f);
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        _mm256_storeu_ps(dst + i, _mm256_mul_ps(_mm256_loadu_ps(in + i), scale));
+    }
+    f32_to_float_scalar(dst + i, in + i, count - i);
+}
+
+__attribute__((target("avx2")))
+static void float_to_f32_avx2(void* dst, const float* src, size_t count) {
+    float* out = (float*)dst;
+    const __m256 scale = _mm256_set1_ps(BUS_TO_F32);
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        _mm256_storeu_ps(out + i, _mm256_mul_ps(_mm256_loadu_ps(src + i), scale));
+    }
+    float_to_f32_scalar(out + i, src + i, count - i);
+}
+
+__attribute__((target("avx2")))
+static void mix_stereo_s16_avx2(float* bus, const int16_t* src, size_t frames, float left_gain, float right_gain) {
+    const __m256 gains = _mm256_setr_ps(left_gain, right_gain, left_gain, right_gain,
+                                        left_gain, right_gain, left_gain, right_gain);
+    size_t j = 0;
+    for (; j + 4 <= frames; j += 4) {
+        __m256 samples = s16x8_to_ps_avx2(src + j * 2);
+        _mm256_storeu_ps(bus + j * 2, _mm256_add_ps(_mm256_loadu_ps(bus + j * 2), _mm256_mul_ps(samples, gains)));
+    }
+    mix_stereo_s16_scalar(bus + j * 2, src + j * 2, frames - j, left_gain, right_gain);
+}
+
+__attribute__((target("avx2")))
+static inline void mix_mono_ps_avx2(float* out, __m256 samples, __m256 lg, __m256 rg) {
+    __m256 l = _mm256_mul_ps(samples, lg);
+    __m256 r = _mm256_mul_ps(samples, rg);
+    __m256 lo = _mm256_unpacklo_ps(l, r);
+    __m256 hi = _mm256_unpackhi_ps(l, r);
+    _mm256_storeu_ps(out, _mm256_add_ps(_mm256_loadu_ps(out), _mm256_permute2f128_ps(lo, hi, 0x20)));
+    _mm256_storeu_ps(out + 8, _mm256_add_ps(_mm256_loadu_ps(out + 8), _mm256_permute2f128_ps(lo, hi, 0x31)));
+}
+
+__attribute__((target("avx2")))
+static void mix_mono_s16_avx2(float* bus, const int16_t* src, size_t frames, float left_gain, float right_gain) {
+    const __m256 lg = _mm256_set1_ps(left_gain);
+    const __m256 rg = _mm256_set1_ps(right_gain);
+    size_t j = 0;
+    for (; j + 8 <= frames; j += 8) {
+        mix_mono_ps_avx2(bus + j * 2, s16x8_to_ps_avx2(src + j), lg, rg);
+    }
+    mix_mono_s16_scalar(bus + j * 2, src + j, frames - j, left_gain, right_gain);
+}
+
+__attribute__((target("avx2")))
+static void mix_stereo_f32_avx2(float* bus, const float* src, size_t frames, float left_gain, float right_gain) {
+    const __m256 gains = _mm256_setr_ps(left_gain, right_gain, left_gain, right_gain,
+                                        left_gain, right_gain, left_gain, right_gain);
+    size_t j = 0;
+    for (; j + 4 <= frames; j += 4) {
+        __m256 v = _mm256_mul_ps(_mm256_loadu_ps(src + j * 2), gains);
+        _mm256_storeu_ps(bus + j * 2, _mm256_add_ps(_mm256_loadu_ps(bus + j * 2), v));
+    }
+    mix_stereo_f32_scalar(bus + j * 2, src + j * 2, frames - j, left_gain, right_gain);
+}
+
+__attribute__((target("avx2")))
+static void mix_mono_f32_avx2(float* bus, const float* src, size_t frames, float left_gain, float right_gain) {
+    const __m256 lg = _mm256_set1_ps(left_gain);
+    const __m256 rg = _mm256_set1_ps(right_gain);
+    size_t j = 0;
+    for (; j + 8 <= frames; j += 8) {
+        mix_mono_ps_avx2(bus + j * 2, _mm256_loadu_ps(src + j), lg, rg);
+    }
+    mix_mono_f32_scalar(bus + j * 2, src + j, frames - j, left_gain, right_gain);
+}
+
+__attribute__((target("avx2")))
+static float dot_f32_avx2(const float* a, const float* b, size_t count) {
+    __m256 acc = _mm256_setzero_ps();
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        acc = _mm256_add_ps(acc, _mm256_mul_ps(_mm256_loadu_ps(a + i), _mm256_loadu_ps(b + i)));
+    }
+    __m128 sum = _mm_add_ps(_mm256_castps256_ps128(acc), _mm256_extractf128_ps(acc, 1));
+    sum = _mm_add_ps(sum, _mm_movehl_ps(sum, sum));
+    sum = _mm_add_ss(sum, _mm_shuffle_ps(sum, sum, 1));
+    return _mm_cvtss_f32(sum) + dot_f32_scalar(a + i, b + i, count - i);
+}
+
+/*
+ * Um quadro do barramento por registrador (até 8 canais, com máscara no fim).
+ * Até 5.1/7.1 com entradas de até 16 canais as colunas ficam em registradores.
+ */
+__attribute__((target("avx2")))
+static void mix_matrix_f32_avx2(float* bus, size_t bus_channels, const float* src, size_t src_channels,
+                                size_t frames, const float* matrix) {
+    static const int32_t mask_table[16] = { -1, -1, -1, -1, -1, -1, -1, -1, 0, 0, 0, 0, 0, 0, 0, 0 };
+
+    if (bus_channels <= 8 && src_channels <= 16) {
+        __m256i mask = _mm256_loadu_si256((const __m256i*)(mask_table + 8 - bus_channels));
+        __m256 columns[16];
+        for (size_t i = 0; i < src_channels; i++) {
+            columns[i] = _mm256_maskload_ps(matrix + i * bus_channels, mask);
+        }
+        for (size_t j = 0; j < frames; j++) {
+            const float* in = src + j * src_channels;
+            float* out = bus + j * bus_channels;
+            __m256 acc = _mm256_maskload_ps(out, mask);
+            for (size_t i = 0; i < src_channels; i++) {
+                acc = _mm256_add_ps(acc, _mm256_mul_ps(_mm256_set1_ps(in[i]), columns[i]));
+            }
+            _mm256_maskstore_ps(out, mask, acc);
+        }
+        return;
+    }
+
+    for (size_t j = 0; j < frames; j++) {
+        const float* in = src + j * src_channels;
+        float* out = bus + j * bus_channels;
+        for (size_t o = 0; o < bus_channels; o += 8) {
+            size_t lanes = bus_channels - o < 8 ? bus_channels - o : 8;
+            __m256i mask = _mm256_loadu_si256((const __m256i*)(mask_table + 8 - lanes));
+            __m256 acc = _mm256_maskload_ps(out + o, mask);
+            for (size_t i = 0; i < src_channels; i++) {
+                __m256 column = _mm256_maskload_ps(matrix + i * bus_channels + o, mask);
+                acc = _mm256_add_ps(acc, _mm256_mul_ps(_mm256_set1_ps(in[i]), column));
+            }
+            _mm256_maskstore_ps(out + o, mask, acc);
+        }
+    }
+}
+
+/* Como na versão SSE2; as metades de 128 bits têm a mesma ordem de canais. */
+__attribute__((target("avx2")))
+static void peak_stats_f32_avx2(const float* src, size_t frames, size_t stride, size_t channels,
+                                float* min, float* max, float* squares) {
+    if (stride != channels || channels > 2) {
+        peak_stats_f32_scalar(src, frames, stride, channels, min, max, squares);
+        return;
+    }
+
+    __m256 low = _mm256_set1_ps(FLT_MAX);
+    __m256 high = _mm256_set1_ps(-FLT_MAX);
+    __m256 sum = _mm256_setzero_ps();
+    size_t count = frames * channels;
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m256 v = _mm256_loadu_ps(src + i);
+        low = _mm256_min_ps(low, v);
+        high = _mm256_max_ps(high, v);
+        sum = _mm256_add_ps(sum, _mm256_mul_ps(v, v));
+    }
+    peak_stats_store_sse2(_mm_min_ps(_mm256_castps256_ps128(low), _mm256_extractf128_ps(low, 1)),
+                          _mm_max_ps(_mm256_castps256_ps128(high), _mm256_extractf128_ps(high, 1)),
+                          _mm_add_ps(_mm256_castps256_ps128(sum), _mm256_extractf128_ps(sum, 1)),
+                          channels, min, max, squares);
+    peak_stats_f32_scalar(src + i, frames - i / channels, stride, channels, min, max, squares);
+}
+
+__attribute__((target("avx2")))
+static void fft_stage_f32_avx2(float* re, float* im, size_t size, size_t half, const float* w_re, const float* w_im) {
+    if (half < 8) {
+        fft_stage_f32_sse2(re, im, size, half, w_re, w_im);
+        return;
+    }
+
+    for (size_t group = 0; group < size; group += 2 * half) {
+        float* ar = re + group;
+        float* ai = im + group;
+        float* br = ar + half;
+        float* bi = ai + half;
+        for (size_t j = 0; j < half; j += 8) {
+            __m256 wr = _mm256_loadu_ps(w_re + j);
+            __m256 wi = _mm256_loadu_ps(w_im + j);
+            __m256 xr = _mm256_loadu_ps(br + j);
+            __m256 xi = _mm256_loadu_ps(bi + j);
+            __m256 tr = _mm256_sub_ps(_mm256_mul_ps(xr, wr), _mm256_mul_ps(xi, wi));
+            __m256 ti = _mm256_add_ps(_mm256_mul_ps(xr, wi), _mm256_mul_ps(xi, wr));
+            __m256 yr = _mm256_loadu_ps(ar + j);
+            __m256 yi = _mm256_loadu_ps(ai + j);
+            _mm256_storeu_ps(br + j, _mm256_sub_ps(yr, tr));
+            _mm256_storeu_ps(bi + j, _mm256_sub_ps(yi, ti));
+            _mm256_storeu_ps(ar + j, _mm256_add_ps(yr, tr));
+            _mm256_storeu_ps(ai + j, _mm256_add_ps(yi, ti));
+        }
+    }
+}
+
+static const MixKernels kernels_avx2 = {
+    MIX_SIMD_AVX2, "avx2",
+    s16_to_float_avx2, float_to_s16_avx2, mix_stereo_s16_avx2, mix_mono_s16_avx2,
+    { NULL, u8_to_float_avx2, s16v_to_float_avx2, s24_to_float_avx2, s32_to_float_avx2, f32_to_float_avx2 },
+    { NULL, float_to_u8_avx2, float_to_s16v_avx2, float_to_s24_avx2, float_to_s32_avx2, float_to_f32_avx2 },
+    mix_stereo_f32_avx2, mix_mono_f32_avx2, dot_f32_avx2, mix_matrix_f32_avx2,
+    peak_stats_f32_avx2, fft_stage_f32_avx2
+};
+
+/* ---------- AVX-512F: 16 floats por registrador ---------- */
+
+__attribute__((target("avx512f")))
+static inline __m512 s16x16_to_ps_avx512(const int16_t* src) {
+    return _mm512_cvtepi32_ps(_mm512_cvtepi16_epi32(_mm256_loadu_si256((const __m256i*)src)));
+}
+
+__attribute__((target("avx512f")))
+static void s16_to_float_avx512(float* dst, const int16_t* src, size_t count) {
+    size_t i = 0;
+    for (; i + 16 <= count; i += 16) {
+        _mm512_storeu_ps(dst + i, s16x16_to_ps_avx512(src + i));
+    }
+    s16_to_float_scalar(dst + i, src + i, count - i);
+}
+
+__attribute__((target("avx512f")))
+static void float_to_s16_avx512(int16_t* dst, const float* src, size_t count) {
+    const __m512 max_value = _mm512_set1_ps(32767.0f);
+    const __m512 min_value = _mm512_set1_ps(-32768.0f);
+    size_t i = 0;
+    for (; i + 16 <= count; i += 16) {
+        __m512 v = _mm512_max_ps(_mm512_min_ps(_mm512_loadu_ps(src + i), max_value), min_value);
+        _mm256_storeu_si256((__m256i*)(dst + i), _mm512_cvtsepi32_epi16(_mm512_cvttps_epi32(v)));
+    }
+    float_to_s16_scalar(dst + i, src + i, count - i);
+}
+
+__attribute__((target("avx512f")))
+static void s16v_to_float_avx512(float* dst, const void* src, size_t count) {
+    s16_to_float_avx512(dst, (const int16_t*)src, count);
+}
+
+__attribute__((target("avx512f")))
+static void float_to_s16v_avx512(void* dst, const float* src, size_t count) {
+    float_to_s16_avx512((int16_t*)dst, src, count);
+}
+
+__attribute__((target("avx512f")))
+static void u8_to_float_avx512(float* dst, const void* src, size_t count) {
+    const uint8_t* in = (const uint8_t*)src;
+    const __m512i bias = _mm512_set1_epi32(128);
+    const __m512 scale = _mm512_set1_ps(256.0f);
+    size_t i = 0;
+    for (; i + 16 <= count; i += 16) {
+        __m512i v = _mm512_cvtepu8_epi32(_mm_loadu_si128((const __m128i*)(in + i)));
+        _mm512_storeu_ps(dst + i, _mm512_mul_ps(_mm512_cvtepi32_ps(_mm512_sub_epi32(v, bias)), scale));
+    }
+    u8_to_float_scalar(dst + i, in + i, count - i);
+}
+
+__attribute__((target("avx512f")))
+static void float_to_u8_avx512(void* dst, const float* src, size_t count) {
+    uint8_t* out = (uint8_t*)dst;
+    const __m512 scale = _mm512_set1_ps(1.0f / 256.0f);
+    const __m512 max_value = _mm512_set1_ps(127.0f);
+    const __m512 min_value = _mm512_set1_ps(-128.0f);
+    const __m512i bias = _mm512_set1_epi32(128);
+    size_t i = 0;
+    for (; i + 16 <= count; i += 16) {
+        __m512 v = _mm512_mul_ps(_mm512_loadu_ps(src + i), scale);
+        v = _mm512_max_ps(_mm512_min_ps(v, max_value), min_value);
+        __m512i ints = _mm512_add_epi32(_mm512_cvttps_epi32(v), bias);
+        _mm_storeu_si128((__m128i*)(out + i), _mm512_cvtusepi32_epi8(ints));
+    }
+    float_to_u8_scalar(out + i, src + i, count - i);
+}
+
+__attribute__((target("avx512f")))
+static void s32_to_float_avx512(float* dst, const void* src, size_t count) {
+    const int32_t* in = (const int32_t*)src;
+    const __m512 scale = _mm512_set1_ps(S32_TO_BUS);
+    size_t i = 0;
+    for (; i + 16 <= count; i += 16) {
+        __m512 v = _mm512_cvtepi32_ps(_mm512_loadu_si512((const void*)(in + i)));
+        _mm512_storeu_ps(dst + i, _mm512_mul_ps(v, scale));
+    }
+    s32_to_float_scalar(dst + i, in + i, count - i);
+}
+
+__attribute__((target("avx512f")))
+static void float_to_s32_avx512(void* dst, const float* src, size_t count) {
+    int32_t* out = (int32_t*)dst;
+    const __m512 scale = _mm512_set1_ps(65536.0f);
+    const __m512 max_value = _mm512_set1_ps(S32_MAX_FLOAT);
+    const __m512 min_value = _mm512_set1_ps(S32_MIN_FLOAT);
+    size_t i = 0;
+    for (; i + 16 <= count; i += 16) {
+        __m512 v = _mm512_mul_ps(_mm512_loadu_ps(src + i), scale);
+        v = _mm512_max_ps(_mm512_min_ps(v, max_value), min_value);
+        _mm512_storeu_si512((void*)(out + i), _mm512_cvttps_epi32(v));
+    }
+    float_to_s32_scalar(out + i, src + i, count - i);
+}
+
+__attribute__((target("avx512f")))
+static void f32_to_float_avx512(float* dst, const void* src, size_t count) {
+    const float* in = (const float*)src;
+    const __m512 scale = _mm512_set1_ps(32768.0f);
+    size_t i = 0;
+    for (; i + 16 <= count; i += 16) {
+        _mm512_storeu_ps(dst + i, _mm512_mul_ps(_mm512_loadu_ps(in + i), scale));
+    }
+    f32_to_float_scalar(dst + i, in + i, count - i);
+}
+
+__attribute__((target("avx512f")))
+static void float_to_f32_avx512(void* dst, const float* src, size_t count) {
+    float* out = (float*)dst;
+    const __m512 scale = _mm512_set1_ps(BUS_TO_F32);
+    size_t i = 0;
+    for (; i + 16 <= count; i += 16) {
+        _mm512_storeu_ps(out + i, _mm512_mul_ps(_mm512_loadu_ps(src + i), scale));
+    }
+    float_to_f32_scalar(out + i, src + i, count - i);
+}
+
+__attribute__((target("avx512f")))
+static void mix_stereo_s16_avx512(float* bus, const int16_t* src, size_t frames, float left_gain, float right_gain) {
+    const __m512 gains = _mm512_setr_ps(left_gain, right_gain, left_gain, right_gain,
+                                        left_gain, right_gain, left_gain, right_gain,
+                                        left_gain, right_gain, left_gain, right_gain,
+                                        left_gain, right_gain, left_gain, right_gain);
+    size_t j = 0;
+    for (; j + 8 <= frames; j += 8) {
+        __m512 samples = s16x16_to_ps_avx512(src + j * 2);
+        _mm512_storeu_ps(bus + j * 2, _mm512_add_ps(_mm512_loadu_ps(bus + j * 2), _mm512_mul_ps(samples, gains)));
+    }
+    mix_stereo_s16_scalar(bus + j * 2, src + j * 2, frames - j, left_gain, right_gain);
+}
+
+__attribute__((target("avx512f")))
+static inline void mix_mono_ps_avx512(float* out, __m512 samples, __m512 lg, __m512 rg) {
+    const __m512i interleave_lo = _mm512_setr_epi32(0, 16, 1, 17, 2, 18, 3, 19, 4, 20, 5, 21, 6, 22, 7, 23);
+    const __m512i interleave_hi = _mm512_setr_epi32(8, 24, 9, 25, 10, 26, 11, 27, 12, 28, 13, 29, 14, 30, 15, 31);
+    __m512 l = _mm512_mul_ps(samples, lg);
+    __m512 r = _mm512_mul_ps(samples, rg);
+    _mm512_storeu_ps(out, _mm512_add_ps(_mm512_loadu_ps(out), _mm512_permutex2var_ps(l, interleave_lo, r)));
+    _mm512_storeu_ps(out + 16, _mm512_add_ps(_mm512_loadu_ps(out + 16), _mm512_permutex2var_ps(l, interleave_hi, r)));
+}
+
+__attribute__((target("avx512f")))
+static void mix_mono_s16_avx512(float* bus, const int16_t* src, size_t frames, float left_gain, float right_gain) {
+    const __m512 lg = _mm512_set1_ps(left_gain);
+    const __m512 rg = _mm512_set1_ps(right_gain);
+    size_t j = 0;
+    for (; j + 16 <= frames; j += 16) {
+        mix_mono_ps_avx512(bus + j * 2, s16x16_to_ps_avx512(src + j), lg, rg);
+    }
+    mix_mono_s16_scalar(bus + j * 2, src + j, frames - j, left_gain, right_gain);
+}
+
+__attribute__((target("avx512f")))
+static void mix_stereo_f32_avx512(float* bus, const float* src, size_t frames, float left_gain, float right_gain) {
+    const __m512 gains = _mm512_setr_ps(left_gain, right_gain, left_gain, right_gain,
+                                        left_gain, right_gain, left_gain, right_gain,
+                                        left_gain, right_gain, left_gain, right_gain,
+                                        left_gain, right_gain, left_gain, right_gain);
+    size_t j = 0;
+    for (; j + 8 <= frames; j += 8) {
+        __m512 v = _mm512_mul_ps(_mm512_loadu_ps(src + j * 2), gains);
+        _mm512_storeu_ps(bus + j * 2, _mm512_add_ps(_mm512_loadu_ps(bus + j * 2), v));
+    }
+    mix_stereo_f32_scalar(bus + j * 2, src + j * 2, frames - j, left_gain, right_gain);
+}
+
+__attribute__((target("avx512f")))
+static void mix_mono_f32_avx512(float* bus, const float* src, size_t frames, float left_gain, float right_gain) {
+    const __m512 lg = _mm512_set1_ps(left_gain);
+    const __m512 rg = _mm512_set1_ps(right_gain);
+    size_t j = 0;
+    for (; j + 16 <= frames; j += 16) {
+        mix_mono_ps_avx512(bus + j * 2, _mm512_loadu_ps(src + j), lg, rg);
+    }
+    mix_mono_f32_scalar(bus + j * 2, src + j, frames - j, left_gain, right_gain);
+}
+
+__attribute__((target("avx512f")))
+static float dot_f32_avx512(const float* a, const float* b, size_t count) {
+    __m512 acc = _mm512_setzero_ps();
+    size_t i = 0;
+    for (; i + 16 <= count; i += 16) {
+        acc = _mm512_add_ps(acc, _mm512_mul_ps(_mm512_loadu_ps(a + i), _mm512_loadu_ps(b + i)));
+    }
+    return _mm512_reduce_add_ps(acc) + dot_f32_scalar(a + i, b + i, count - i);
+}
+
+/* Como na versão AVX2, mas com até 16 canais do barramento por registrador. */
+__attribute__((target("avx512f")))
+static void mix_matrix_f32_avx512(float* bus, size_t bus_channels, const float* src, size_t src_channels,
+                                  size_t frames, const float* matrix) {
+    if (bus_channels <= 16 && src_channels <= 16) {
+        __mmask16 mask = (__mmask16)((1u << bus_channels) - 1);
+        __m512 columns[16];
+        for (size_t i = 0; i < src_channels; i++) {
+            columns[i] = _mm512_maskz_loadu_ps(mask, matrix + i * bus_channels);
+        }
+        for (size_t j = 0; j < frames; j++) {
+            const float* in = src + j * src_channels;
+            float* out = bus + j * bus_channels;
+            __m512 acc = _mm512_maskz_loadu_ps(mask, out);
+            for (size_t i = 0; i < src_channels; i++) {
+                acc = _mm512_add_ps(acc, _mm512_mul_ps(_mm512_set1_ps(in[i]), columns[i]));
+            }
+            _mm512_mask_storeu_ps(out, mask, acc);
+        }
+        return;
+    }
+
+    for (size_t j = 0; j < frames; j++) {
+        const float* in = src + j * src_channels;
+        float* out = bus + j * bus_channels;
+        for (size_t o = 0; o < bus_channels; o += 16) {
+            size_t lanes = bus_channels - o < 16 ? bus_channels - o : 16;
+            __mmask16 mask = (__mmask16)((1u << lanes) - 1);
+            __m512 acc = _mm512_maskz_loadu_ps(mask, out + o);
+            for (size_t i = 0; i < src_channels; i++) {
+                __m512 column = _mm512_maskz_loadu_ps(mask, matrix + i * bus_channels + o);
+                acc = _mm512_add_ps(acc, _mm512_mul_ps(_mm512_set1_ps(in[i]), column));
+            }
+            _mm512_mask_storeu_ps(out + o, mask, acc);
+        }
+    }
+}
+
+/* Como na versão SSE2; cada canal é reduzido com a máscara das suas faixas. */
+__attribute__((target("avx512f")))
+static void peak_stats_f32_avx512(const float* src, size_t frames, size_t stride, size_t channels,
+                                  float* min, float* max, float* squares) {
+    if (stride != channels || channels > 2) {
+        peak_stats_f32_scalar(src, frames, stride, channels, min, max, squares);
+        return;
+    }
+
+    __m512 low = _mm512_set1_ps(FLT_MAX);
+    __m512 high = _mm512_set1_ps(-FLT_MAX);
+    __m512 sum = _mm512_setzero_ps();
+    size_t count = frames * channels;
+    size_t i = 0;
+    for (; i + 16 <= count; i += 16) {
+        __m512 v = _mm512_loadu_ps(src + i);
+        low = _mm512_min_ps(low, v);
+        high = _mm512_max_ps(high, v);
+        sum = _mm512_fmadd_ps(v, v, sum);
+    }
+
+    static const __mmask16 masks[2][2] = { { 0xFFFF, 0 }, { 0x5555, 0xAAAA } };
+    for (size_t c = 0; c < channels; c++) {
+        __mmask16 mask = masks[channels - 1][c];
+        float lane_min = _mm512_mask_reduce_min_ps(mask, low);
+        float lane_max = _mm512_mask_reduce_max_ps(mask, high);
+        if (lane_min < min[c]) min[c] = lane_min;
+        if (lane_max > max[c]) max[c] = lane_max;
+        squares[c] += _mm512_mask_reduce_add_ps(mask, sum);
+    }
+    peak_stats_f32_scalar(src + i, frames - i / channels, stride, channels, min, max, squares);
+}
+
+__attribute__((target("avx512f")))
+static void fft_stage_f32_avx512(float* re, float* im, size_t size, size_t half, const float* w_re, const float* w_im) {
+    if (half < 16) {
+        fft_stage_f32_avx2(re, im, size, half, w_re, w_im);
+        return;
+    }
+
+    for (size_t group = 0; group < size; group += 2 * half) {
+        float* ar = re + group;
+        float* ai = im + group;
+        float* br = ar + half;
+        float* bi = ai + half;
+        for (size_t j = 0; j < half; j += 16) {
+            __m512 wr = _mm512_loadu_ps(w_re + j);
+            __m512 wi = _mm512_loadu_ps(w_im + j);
+            __m512 xr = _mm512_loadu_ps(br + j);
+            __m512 xi = _mm512_loadu_ps(bi + j);
+            __m512 tr = _mm512_fmsub_ps(xr, wr, _mm512_mul_ps(xi, wi));
+            __m512 ti = _mm512_fmadd_ps(xr, wi, _mm512_mul_ps(xi, wr));
+            __m512 yr = _mm512_loadu_ps(ar + j);
+            __m512 yi = _mm512_loadu_ps(ai + j);
+            _mm512_storeu_ps(br + j, _mm512_sub_ps(yr, tr));
+            _mm512_storeu_ps(bi + j, _mm512_sub_ps(yi, ti));
+            _mm512_storeu_ps(ar + j, _mm512_add_ps(yr, tr));
+            _mm512_storeu_ps(ai + j, _mm512_add_ps(yi, ti));
+        }
+    }
+}
+
+/* 24 bits precisa de embaralhamento de bytes (AVX-512BW); usa a versão AVX2. */
+static const MixKernels kernels_avx512 = {
+    MIX_SIMD_AVX512, "avx512",
+    s16_to_float_avx512, float_to_s16_avx512, mix_stereo_s16_avx512, mix_mono_s16_avx512,
+    { NULL, u8_to_float_avx512, s16v_to_float_avx512, s24_to_float_avx2, s32_to_float_avx512, f32_to_float_avx512 },
+    { NULL, float_to_u8_avx512, float_to_s16v_avx512, float_to_s24_avx2, float_to_s32_avx512, float_to_f32_avx512 },
+    mix_stereo_f32_avx512, mix_mono_f32_avx512, dot_f32_avx512, mix_matrix_f32_avx512,
+    peak_stats_f32_avx512, fft_stage_f32_avx512
+};
+
+#endif
+
+const MixKernels* mix_kernels_for_level(MixSimdLevel level) {
+#ifdef MIX_KERNELS_X86
+    __builtin_cpu_init();
+#endif
+    switch (level) {
+    case MIX_SIMD_SCALAR:
+        return &kernels_scalar;
+#ifdef MIX_KERNELS_X86
+    case MIX_SIMD_SSE2:
+        return __builtin_cpu_supports("sse2") ? &kernels_sse2 : NULL;
+    case MIX_SIMD_AVX2:
+        return __builtin_cpu_supports("avx2") ? &kernels_avx2 : NULL;
+    case MIX_SIMD_AVX512:
+        return __builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx2") ? &kernels_avx512 : NULL;
+#endif
+    default:
+        return NULL;
+    }
+}
+
+static const MixKernels* selected_kernels = &kernels_scalar;
+static pthread_once_t select_once = PTHREAD_ONCE_INIT;
+
+static void select_kernels(void) {
+    for (int level = MIX_SIMD_AVX512; level > MIX_SIMD_SCALAR; level--) {
+        const MixKernels* kernels = mix_kernels_for_level((MixSimdLevel)level);
+        if (kernels) {
+            selected_kernels = kernels;
+            return;
+        }
+    }
+}
+
+/* A escolha é feita uma vez só, mesmo com várias threads chamando ao mesmo tempo. */
+const MixKernels* mix_kernels_get(void) {
+    pthread_once(&select_once, select_kernels);
+    return selected_kernels;
+}
@@ -0,0 +1,63 @@
+#ifndef MIX_KERNELS_H
+#define MIX_KERNELS_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "wav_reader.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef enum {
+    MIX_SIMD_SCALAR = 0,
+    MIX_SIMD_SSE2,
+    MIX_SIMD_AVX2,
+    MIX_SIMD_AVX512
+} MixSimdLevel;
+
+/*
+ * Laços internos da mixagem. O barramento é float intercalado (L, R) na
+ * escala de 16 bits; a conversão final satura em [-32768, 32767] e trunca,
+ * como a versão escalar sempre fez.
+ * to_float/from_float convertem entre o formato do arquivo (indexado por
+ * WavSampleFormat) e essa mesma escala; a saída em float não satura.
+ * dot_f32 é o produto escalar usado pelos filtros do reamostrador.
+ * mix_matrix_f32 soma uma entrada de src_channels canais num barramento de
+ * bus_channels canais; a coluna i da matriz (matrix + i * bus_channels) é o
+ * ganho do canal de entrada i em cada canal do barramento.
+ * peak_stats_f32 acumula, para cada um dos primeiros "channels" canais de um
+ * trecho intercalado com "stride" canais por quadro, o mínimo, o máximo e a
+ * soma dos quadrados (quem chama começa com +inf, -inf e 0).
+ * fft_stage_f32 faz um estágio radix-2 (dizimação no tempo) de uma FFT de
+ * size pontos, com as partes real e imaginária em vetores separados: em cada
+ * grupo de 2 * half pontos, a segunda metade é multiplicada pelos fatores
+ * (w_re[j], w_im[j]) e somada/subtraída da primeira.
+ */
+typedef struct {
+    MixSimdLevel level;
+    const char* name;
+    void (*s16_to_float)(float* dst, const int16_t* src, size_t count);
+    void (*float_to_s16)(int16_t* dst, const float* src, size_t count);
+    void (*mix_stereo_s16)(float* bus, const int16_t* src, size_t frames, float left_gain, float right_gain);
+    void (*mix_mono_s16)(float* bus, const int16_t* src, size_t frames, float left_gain, float right_gain);
+    void (*to_float[WAV_SAMPLE_FORMAT_COUNT])(float* dst, const void* src, size_t count);
+    void (*from_float[WAV_SAMPLE_FORMAT_COUNT])(void* dst, const float* src, size_t count);
+    void (*mix_stereo_f32)(float* bus, const float* src, size_t frames, float left_gain, float right_gain);
+    void (*mix_mono_f32)(float* bus, const float* src, size_t frames, float left_gain, float right_gain);
+    float (*dot_f32)(const float* a, const float* b, size_t count);
+    void (*mix_matrix_f32)(float* bus, size_t bus_channels, const float* src, size_t src_channels,
+                           size_t frames, const float* matrix);
+    void (*peak_stats_f32)(const float* src, size_t frames, size_t stride, size_t channels,
+                           float* min, float* max, float* squares);
+    void (*fft_stage_f32)(float* re, float* im, size_t size, size_t half, const float* w_re, const float* w_im);
+} MixKernels;
+
+const MixKernels* mix_kernels_get(void);
+const MixKernels* mix_kernels_for_level(MixSimdLevel level);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,842 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <pthread.h>
+#include <sys/stat.h>
+#ifdef _WIN32
+#include <windows.h>
+#include <io.h>
+#include <process.h>
+#include <sys/utime.h>
+#define getpid _getpid
+#define utime _utime
+#else
+#include <unistd.h>
+#include <dirent.h>
+#include <utime.h>
+#include <sys/mman.h>
+#endif
+#include "peaks.h"
+#include "mix_kernels.h"
+
+#define PEAK_CACHE_VERSION 3
+
+/*
+ * Espaço que o diretório de cache pode ocupar; passando disso, os arquivos
+ * usados há mais tempo são apagados depois de cada gravação.
+ */
+#define PEAK_CACHE_MAX_BYTES ((uint64_t)512 << 20)
+
+/* O que identifica a versão de um WAV no disco; no Windows, mtime_nsec e inode ficam em zero. */
+typedef struct {
+    uint64_t size;
+    int64_t mtime;
+    int64_t mtime_nsec;
+    uint64_t device;
+    uint64_t inode;
+} FileIdentity;
+
+/*
+ * Cabeçalho do arquivo de cache. Logo depois vem o caminho do WAV (path_length
+ * bytes) e, a partir de levels_offset, os níveis em sequência. O cache só vale
+ * se o WAV ainda tem o mesmo caminho, tamanho, data de modificação (com os
+ * nanossegundos), dispositivo, inode e formato.
+ */
+typedef struct {
+    char magic[4];
+    uint32_t version;
+    uint32_t base_frames;
+    uint32_t value_size;
+    uint64_t file_size;
+    int64_t file_mtime;
+    int64_t file_mtime_nsec;
+    uint64_t file_device;
+    uint64_t file_inode;
+    uint16_t audio_format;
+    uint16_t num_channels;
+    uint16_t bits_per_sample;
+    uint16_t peak_channels;
+    uint32_t sample_rate;
+    uint32_t level_count;
+    uint64_t frames;
+    int32_t max_abs;
+    uint32_t path_length;
+    uint32_t levels_offset;
+    uint32_t reserved2;
+    uint64_t counts[PEAK_MAX_LEVELS];
+} PeakCacheHeader;
+
+/* Cálculo em segundo plano de uma pirâmide; os blocos são distribuídos entre as threads. */
+struct PeakJob {
+    PeakPyramid* peaks;
+    WavReader reader;
+    char* filename;
+    FileIdentity identity;
+    int cacheable;
+    uint64_t next_block;
+    int users;
+    PeakJob* next;
+};
+
+/*
+ * Fila de pirâmides a calcular e as threads que a atendem. Todas as threads
+ * trabalham na primeira pirâmide da fila até os blocos dela acabarem, então
+ * um arquivo longo fica pronto antes do próximo começar.
+ */
+struct PeakBuilder {
+    pthread_mutex_t lock;
+    pthread_cond_t wake;
+    pthread_cond_t idle;
+    PeakJob* first;
+    PeakJob* last;
+    pthread_t* threads;
+    int thread_count;
+    int quit;
+    void (*progress)(void* user);
+    void* user;
+    char* cache_dir;
+};
+
+static int16_t peak_clamp(float value) {
+    if (value > 32767.0f) return 32767;
+    if (value < -32768.0f) return -32768;
+    return (int16_t)value;
+}
+
+static int peak_thread_count(void) {
+#ifdef _WIN32
+    SYSTEM_INFO system_info;
+    GetSystemInfo(&system_info);
+    long count = system_info.dwNumberOfProcessors;
+#else
+    long count = sysconf(_SC_NPROCESSORS_ONLN);
+#endif
+    return count > 0 ? (int)count : 1;
+}
+
+/* Canais com picos próprios num arquivo de num_channels canais. */
+static int peak_channel_count(uint16_t num_channels) {
+    return num_channels < PEAK_MAX_CHANNELS ? num_channels : PEAK_MAX_CHANNELS;
+}
+
+/*
+ * Resume "frames" quadros já convertidos para float (intercalados, "stride"
+ * canais por quadro) num pico do nível 0 para cada um dos "channels" canais.
+ */
+static void peak_from_samples(const float* samples, size_t frames, uint16_t stride, int channels, PeakValue* result) {
+    float min[PEAK_MAX_CHANNELS], max[PEAK_MAX_CHANNELS], squares[PEAK_MAX_CHANNELS];
+    for (int c = 0; c < channels; c++) {
+        min[c] = INFINITY;
+        max[c] = -INFINITY;
+        squares[c] = 0.0f;
+    }
+    mix_kernels_get()->peak_stats_f32(samples, frames, stride, (size_t)channels, min, max, squares);
+
+    for (int c = 0; c < channels; c++) {
+        result[c].min = peak_clamp(frames > 0 ? min[c] : 0.0f);
+        result[c].max = peak_clamp(frames > 0 ? max[c] : 0.0f);
+        result[c].rms = peak_clamp(frames > 0 ? sqrtf(squares[c] / frames) : 0.0f);
+    }
+}
+
+/*
+ * Junta "count" posições vizinhas de um canal; os picos de um mesmo canal
+ * ficam a "channels" valores um do outro. O RMS é a média quadrática dos RMS.
+ */
+static PeakValue peak_combine(const PeakValue* peaks, size_t count, int channels) {
+    PeakValue result = peaks[0];
+    double squares = (double)peaks[0].rms * peaks[0].rms;
+
+    for (size_t i = 1; i < count; i++) {
+        const PeakValue* peak = &peaks[i * channels];
+        if (peak->min < result.min) result.min = peak->min;
+        if (peak->max > result.max) result.max = peak->max;
+        squares += (double)peak->rms * peak->rms;
+    }
+
+    result.rms = peak_clamp((float)sqrt(squares / count));
+    return result;
+}
+
+/* Monta as posições [first, end) do nível "level" a partir do nível de baixo. */
+static void combine_level(PeakPyramid* peaks, int level, uint64_t first, uint64_t end) {
+    const PeakValue* below = peaks->levels[level - 1];
+    uint64_t below_count = peaks->counts[level - 1];
+    int channels = peaks->channels;
+
+    if (end > peaks->counts[level]) end = peaks->counts[level];
+    for (uint64_t i = first; i < end; i++) {
+        size_t pair = 2 * i + 1 < below_count ? 2 : 1;
+        for (int c = 0; c < channels; c++) {
+            peaks->levels[level][i * channels + c] = peak_combine(below + 2 * i * channels + c, pair, channels);
+        }
+    }
+}
+
+/* Aloca os níveis para o arquivo já aberto em reader; nada é calculado ainda. */
+static int peak_pyramid_init(PeakPyramid* peaks, const WavReader* reader) {
+    memset(peaks, 0, sizeof(*peaks));
+    peaks->frames = reader->info.duration_samples;
+    peaks->sample_rate = reader->info.sample_rate;
+    peaks->channels = peak_channel_count(reader->info.num_channels);
+
+    peaks->block_count = (peaks->frames + PEAK_BLOCK_FRAMES - 1) / PEAK_BLOCK_FRAMES;
+    if (peaks->block_count == 0) peaks->block_count = 1;
+    peaks->block_ready = calloc((size_t)peaks->block_count, sizeof(*peaks->block_ready));
+    if (!peaks->block_ready) return -1;
+
+    uint64_t count = (peaks->frames + PEAK_BASE_FRAMES - 1) / PEAK_BASE_FRAMES;
+    if (count == 0) count = 1;
+    while (peaks->level_count < PEAK_MAX_LEVELS) {
+        peaks->counts[peaks->level_count] = count;
+        peaks->levels[peaks->level_count] = calloc((size_t)count * peaks->channels, sizeof(PeakValue));
+        if (!peaks->levels[peaks->level_count]) {
+            peak_pyramid_free(peaks);
+            return -1;
+        }
+        peaks->level_count++;
+        if (count == 1) break;
+        count = (count + 1) / 2;
+    }
+
+    return 0;
+}
+
+static int open_peak_reader(WavReader* reader, const char* filename) {
+    if (wav_reader_open(reader, filename, WAV_READER_MAP) != 0) {
+        return -1;
+    }
+    if (reader->format == WAV_SAMPLE_UNSUPPORTED || reader->info.num_channels == 0) {
+        printf("Formato não suportado para a waveform: %s\n", filename);
+        wav_reader_close(reader);
+        return -1;
+    }
+    return 0;
+}
+
+/*
+ * Calcula um bloco: o nível 0 lido do arquivo e os níveis de dentro do bloco.
+ * raw e samples comportam PEAK_BLOCK_FRAMES quadros do arquivo. Depois disso
+ * o bloco é publicado para o desenho.
+ */
+static void compute_block(PeakPyramid* peaks, const WavReader* reader, uint64_t block, uint8_t* raw, float* samples) {
+    uint16_t channels = reader->info.num_channels;
+    uint64_t first_frame = block * PEAK_BLOCK_FRAMES;
+    size_t frames = 0;
+    if (first_frame < peaks->frames) {
+        frames = PEAK_BLOCK_FRAMES;
+        if (frames > peaks->frames - first_frame) frames = (size_t)(peaks->frames - first_frame);
+        frames = wav_reader_read(reader, first_frame, raw, frames);
+    }
+    mix_kernels_get()->to_float[reader->format](samples, raw, frames * channels);
+
+    PeakValue* base = peaks->levels[0];
+    int max_abs = 0;
+    for (size_t offset = 0; offset < frames; offset += PEAK_BASE_FRAMES) {
+        size_t count = frames - offset < PEAK_BASE_FRAMES ? frames - offset : PEAK_BASE_FRAMES;
+        PeakValue* peak = base + (first_frame + offset) / PEAK_BASE_FRAMES * peaks->channels;
+        peak_from_samples(samples + offset * channels, count, channels, peaks->channels, peak);
+        for (int c = 0; c < peaks->channels; c++) {
+            if (peak[c].max > max_abs) max_abs = peak[c].max;
+            if (-peak[c].min > max_abs) max_abs = -peak[c].min;
+        }
+    }
+
+    for (int level = 1; level < peaks->level_count && level <= PEAK_BLOCK_LEVELS; level++) {
+        int shift = PEAK_BLOCK_LEVELS - level;
+        combine_level(peaks, level, block << shift, (block + 1) << shift);
+    }
+
+    if (max_abs > 32767) max_abs = 32767;
+    int current = atomic_load(&peaks->max_abs);
+    while (max_abs > current && !atomic_compare_exchange_weak(&peaks->max_abs, &current, max_abs)) {
+    }
+
+    atomic_store_explicit(&peaks->block_ready[block], 1, memory_order_release);
+}
+
+/* Com todos os blocos prontos, monta os níveis que atravessam blocos. */
+static void finish_pyramid(PeakPyramid* peaks) {
+    for (int level = PEAK_BLOCK_LEVELS + 1; level < peaks->level_count; level++) {
+        combine_level(peaks, level, 0, peaks->counts[level]);
+    }
+    atomic_store_explicit(&peaks->complete, 1, memory_order_release);
+}
+
+void peak_pyramid_free(PeakPyramid* peaks) {
+    if (peaks->map_base) {
+#ifdef _WIN32
+        UnmapViewOfFile(peaks->map_base);
+        CloseHandle((HANDLE)peaks->map_handle);
+#else
+        munmap(peaks->map_base, peaks->map_length);
+#endif
+        peaks->map_base = NULL;
+        memset(peaks->levels, 0, sizeof(peaks->levels));
+    }
+    for (int level = 0; level < PEAK_MAX_LEVELS; level++) {
+        free(peaks->levels[level]);
+        peaks->levels[level] = NULL;
+    }
+    free((void*)peaks->block_ready);
+    peaks->block_ready = NULL;
+    peaks->level_count = 0;
+}
+
+/*
+ * Picos dos quadros [first_frame, end_frame), um por canal em result[0] a
+ * result[channels - 1]: usa o nível mais grosso cujas posições ainda cabem no
+ * trecho, então junta no máximo umas três. Devolve -1 se o trecho está fora
+ * do arquivo ou ainda não foi calculado.
+ */
+int peak_pyramid_query(const PeakPyramid* peaks, uint64_t first_frame, uint64_t end_frame, PeakValue* result) {
+    if (!peaks || peaks->level_count == 0) return -1;
+    if (end_frame > peaks->frames) end_frame = peaks->frames;
+    if (first_frame >= end_frame) return -1;
+
+    int max_level = peaks->level_count - 1;
+    if (!atomic_load_explicit(&peaks->complete, memory_order_acquire)) {
+        for (uint64_t block = first_frame / PEAK_BLOCK_FRAMES; block <= (end_frame - 1) / PEAK_BLOCK_FRAMES; block++) {
+            if (!atomic_load_explicit(&peaks->block_ready[block], memory_order_acquire)) return -1;
+        }
+        if (max_level > PEAK_BLOCK_LEVELS) max_level = PEAK_BLOCK_LEVELS;
+    }
+
+    uint64_t span = end_frame - first_frame;
+    int level = 0;
+    while (level < max_level && ((uint64_t)PEAK_BASE_FRAMES << (level + 1)) <= span) {
+        level++;
+    }
+
+    uint64_t bucket = (uint64_t)PEAK_BASE_FRAMES << level;
+    uint64_t first = first_frame / bucket;
+    uint64_t end = (end_frame + bucket - 1) / bucket;
+    if (end > peaks->counts[level]) end = peaks->counts[level];
+
+    for (int c = 0; c < peaks->channels; c++) {
+        result[c] = peak_combine(peaks->levels[level] + first * peaks->channels + c, (size_t)(end - first), peaks->channels);
+    }
+    return 0;
+}
+
+/*
+ * Picos de [first_frame, end_frame) calculados das amostras, um por canal como
+ * em peak_pyramid_query(), para trechos menores que uma posição do nível 0
+ * (zoom perto das amostras).
+ */
+int peak_read_range(const WavReader* reader, uint64_t first_frame, uint64_t end_frame, PeakValue* result) {
+    if (end_frame > reader->info.duration_samples) end_frame = reader->info.duration_samples;
+    if (first_frame >= end_frame) return -1;
+
+    int channels = peak_channel_count(reader->info.num_channels);
+    for (int c = 0; c < channels; c++) {
+        float min = 0.0f, max = 0.0f;
+        double squares = 0.0;
+        for (uint64_t frame = first_frame; frame < end_frame; frame++) {
+            float value = wav_reader_sample(reader, (size_t)frame, (uint16_t)c);
+            if (frame == first_frame || value < min) min = value;
+            if (frame == first_frame || value > max) max = value;
+            squares += (double)value * value;
+        }
+
+        result[c].min = peak_clamp(min);
+        result[c].max = peak_clamp(max);
+        result[c].rms = peak_clamp((float)sqrt(squares / (double)(end_frame - first_frame)));
+    }
+    return 0;
+}
+
+/* Fração dos blocos já calculados (1 quando a pirâmide está completa). */
+float peak_pyramid_progress(const PeakPyramid* peaks) {
+    if (atomic_load_explicit(&peaks->complete, memory_order_acquire)) return 1.0f;
+    return (float)atomic_load(&peaks->blocks_done) / (float)peaks->block_count;
+}
+
+static int file_identity(const char* filename, FileIdentity* identity) {
+    memset(identity, 0, sizeof(*identity));
+#ifdef _WIN32
+    struct _stat64 st;
+    if (_stat64(filename, &st) != 0) return -1;
+#else
+    struct stat st;
+    if (stat(filename, &st) != 0) return -1;
+    identity->mtime_nsec = (int64_t)st.st_mtim.tv_nsec;
+    identity->device = (uint64_t)st.st_dev;
+    identity->inode = (uint64_t)st.st_ino;
+#endif
+    identity->size = (uint64_t)st.st_size;
+    identity->mtime = (int64_t)st.st_mtime;
+    return 0;
+}
+
+/* Nome do arquivo de cache: hash FNV-1a do caminho do WAV. */
+static char* cache_path(const PeakBuilder* builder, const char* filename) {
+    uint64_t hash = 14695981039346656037ULL;
+    for (const unsigned char* c = (const unsigned char*)filename; *c; c++) {
+        hash = (hash ^ *c) * 1099511628211ULL;
+    }
+
+    size_t length = strlen(builder->cache_dir) + 32;
+    char* path = malloc(length);
+    if (path) snprintf(path, length, "%s/%016llx.peaks", builder->cache_dir, (unsigned long long)hash);
+    return path;
+}
+
+static uint64_t cache_levels_size(const PeakCacheHeader* header) {
+    uint64_t size = 0;
+    for (uint32_t level = 0; level < header->level_count; level++) {
+        size += header->counts[level] * header->peak_channels * sizeof(PeakValue);
+    }
+    return size;
+}
+
+static void fill_cache_header(PeakCacheHeader* header, const PeakJob* job, const PeakPyramid* peaks) {
+    memset(header, 0, sizeof(*header));
+    memcpy(header->magic, "SWPK", 4);
+    header->version = PEAK_CACHE_VERSION;
+    header->base_frames = PEAK_BASE_FRAMES;
+    header->value_size = sizeof(PeakValue);
+    header->file_size = job->identity.size;
+    header->file_mtime = job->identity.mtime;
+    header->file_mtime_nsec = job->identity.mtime_nsec;
+    header->file_device = job->identity.device;
+    header->file_inode = job->identity.inode;
+    header->audio_format = job->reader.info.audio_format;
+    header->num_channels = job->reader.info.num_channels;
+    header->bits_per_sample = job->reader.info.bits_per_sample;
+    header->peak_channels = (uint16_t)peaks->channels;
+    header->sample_rate = job->reader.info.sample_rate;
+    header->frames = peaks->frames;
+    header->level_count = peaks->level_count;
+    header->path_length = (uint32_t)strlen(job->filename);
+    header->levels_offset = (uint32_t)((sizeof(PeakCacheHeader) + header->path_length + 7) & ~(size_t)7);
+    for (int level = 0; level < peaks->level_count; level++) {
+        header->counts[level] = peaks->counts[level];
+    }
+}
+
+/*
+ * Tenta usar o cache do arquivo do job: se o cabeçalho bate com o WAV, o
+ * arquivo de cache é mapeado e os níveis apontam direto para ele, sem cópia.
+ */
+static int load_cache(const PeakBuilder* builder, PeakJob* job, PeakPyramid* peaks) {
+    char* path = cache_path(builder, job->filename);
+    FILE* file = path ? fopen(path, "rb") : NULL;
+    free(path);
+    if (!file) return -1;
+
+    PeakCacheHeader expected, header;
+    fill_cache_header(&expected, job, peaks);
+    size_t path_length = expected.path_length;
+    char* stored_path = malloc(path_length + 1);
+
+    int valid = stored_path && fread(&header, sizeof(header), 1, file) == 1;
+    if (valid) {
+        expected.max_abs = header.max_abs;
+        valid = memcmp(&header, &expected, sizeof(header)) == 0 &&
+                fread(stored_path, 1, path_length, file) == path_length &&
+                memcmp(stored_path, job->filename, path_length) == 0;
+    }
+    free(stored_path);
+
+    size_t length = (size_t)(expected.levels_offset + cache_levels_size(&expected));
+#ifdef _WIN32
+    struct _stat64 st;
+    int stat_result = _fstat64(_fileno(file), &st);
+#else
+    struct stat st;
+    int stat_result = fstat(fileno(file), &st);
+#endif
+    if (!valid || stat_result != 0 || (uint64_t)st.st_size != length) {
+        fclose(file);
+        return -1;
+    }
+
+#ifdef _WIN32
+    HANDLE mapping = CreateFileMappingA((HANDLE)_get_osfhandle(_fileno(file)), NULL, PAGE_READONLY, 0, 0, NULL);
+    void* base = mapping ? MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0) : NULL;
+    if (!base) {
+        if (mapping) CloseHandle(mapping);
+        fclose(file);
+        return -1;
+    }
+    peaks->map_handle = mapping;
+#else
+    void* base = mmap(NULL, length, PROT_READ, MAP_SHARED, fileno(file), 0);
+    if (base == MAP_FAILED) {
+        fclose(file);
+        return -1;
+    }
+#endif
+    fclose(file);
+
+    /* A data do arquivo de cache marca o último uso, ver prune_cache(). */
+    path = cache_path(builder, job->filename);
+    if (path) utime(path, NULL);
+    free(path);
+
+    /* Os níveis alocados por peak_pyramid_init() dão lugar aos do cache. */
+    uint64_t offset = header.levels_offset;
+    for (int level = 0; level < peaks->level_count; level++) {
+        free(peaks->levels[level]);
+        peaks->levels[level] = (PeakValue*)((uint8_t*)base + offset);
+        offset += peaks->counts[level] * peaks->channels * sizeof(PeakValue);
+    }
+    peaks->map_base = base;
+    peaks->map_length = length;
+    atomic_store(&peaks->max_abs, header.max_abs);
+    atomic_store(&peaks->blocks_done, peaks->block_count);
+    atomic_store_explicit(&peaks->complete, 1, memory_order_release);
+    return 0;
+}
+
+typedef struct {
+    char* path;
+    uint64_t size;
+    int64_t used;
+} CacheFile;
+
+/* Acrescenta name (de dentro do diretório de cache) à lista, se for um arquivo de picos. */
+static int add_cache_file(const PeakBuilder* builder, const char* name, CacheFile** files, size_t* count,
+                          size_t* capacity) {
+    size_t name_length = strlen(name);
+    if (name_length < 6 || strcmp(name + name_length - 6, ".peaks") != 0) return 0;
+
+    size_t length = strlen(builder->cache_dir) + name_length + 2;
+    char* path = malloc(length);
+    if (!path) return -1;
+    snprintf(path, length, "%s/%s", builder->cache_dir, name);
+
+#ifdef _WIN32
+    struct _stat64 st;
+    int stat_result = _stat64(path, &st);
+#else
+    struct stat st;
+    int stat_result = stat(path, &st);
+#endif
+    if (stat_result != 0) {
+        free(path);
+        return 0;
+    }
+
+    if (*count == *capacity) {
+        size_t new_capacity = *capacity ? *capacity * 2 : 64;
+        CacheFile* grown = realloc(*files, new_capacity * sizeof(CacheFile));
+        if (!grown) {
+            free(path);
+            return -1;
+        }
+        *files = grown;
+        *capacity = new_capacity;
+    }
+    (*files)[*count].path = path;
+    (*files)[*count].size = (uint64_t)st.st_size;
+    (*files)[*count].used = (int64_t)st.st_mtime;
+    (*count)++;
+    return 0;
+}
+
+static int compare_cache_files(const void* a, const void* b) {
+    int64_t used_a = ((const CacheFile*)a)->used;
+    int64_t used_b = ((const CacheFile*)b)->used;
+    return used_a < used_b ? -1 : used_a > used_b;
+}
+
+/*
+ * Mantém o diretório de cache abaixo de PEAK_CACHE_MAX_BYTES apagando os
+ * arquivos usados há mais tempo (a data de cada um é renovada quando
+ * load_cache() o aproveita). keep, o que acabou de ser gravado, fica.
+ */
+static void prune_cache(const PeakBuilder* builder, const char* keep) {
+    CacheFile* files = NULL;
+    size_t count = 0, capacity = 0;
+    int ok = 1;
+
+#ifdef _WIN32
+    size_t pattern_length = strlen(builder->cache_dir) + 9;
+    char* pattern = malloc(pattern_length);
+    if (!pattern) return;
+    snprintf(pattern, pattern_length, "%s/*.peaks", builder->cache_dir);
+    WIN32_FIND_DATAA data;
+    HANDLE find = FindFirstFileA(pattern, &data);
+    free(pattern);
+    if (find == INVALID_HANDLE_VALUE) return;
+    do {
+        ok = add_cache_file(builder, data.cFileName, &files, &count, &capacity) == 0;
+    } while (ok && FindNextFileA(find, &data));
+    FindClose(find);
+#else
+    DIR* dir = opendir(builder->cache_dir);
+    if (!dir) return;
+    struct dirent* entry;
+    while (ok && (entry = readdir(dir)) != NULL) {
+        ok = add_cache_file(builder, entry->d_name, &files, &count, &capacity) == 0;
+    }
+    closedir(dir);
+#endif
+
+    uint64_t total = 0;
+    for (size_t i = 0; i < count; i++) {
+        total += files[i].size;
+    }
+    if (ok && total > PEAK_CACHE_MAX_BYTES) {
+        qsort(files, count, sizeof(CacheFile), compare_cache_files);
+        for (size_t i = 0; i < count && total > PEAK_CACHE_MAX_BYTES; i++) {
+            if (strcmp(files[i].path, keep) == 0) continue;
+            if (remove(files[i].path) == 0) total -= files[i].size;
+        }
+    }
+
+    for (size_t i = 0; i < count; i++) {
+        free(files[i].path);
+    }
+    free(files);
+}
+
+/*
+ * Grava a pirâmide completa num arquivo temporário e o renomeia para o cache.
+ * O nome temporário leva o processo e o job, já que o mesmo WAV pode estar
+ * sendo salvo por dois jobs (ou duas instâncias) ao mesmo tempo.
+ */
+static void save_cache(const PeakBuilder* builder, const PeakJob* job, const PeakPyramid* peaks) {
+    char* path = cache_path(builder, job->filename);
+    if (!path) return;
+    size_t temp_length = strlen(path) + 48;
+    char* temp_path = malloc(temp_length);
+    if (!temp_path) {
+        free(path);
+        return;
+    }
+    snprintf(temp_path, temp_length, "%s.%ld.%p.tmp", path, (long)getpid(), (const void*)job);
+
+    PeakCacheHeader header;
+    fill_cache_header(&header, job, peaks);
+    header.max_abs = atomic_load(&peaks->max_abs);
+
+    FILE* file = fopen(temp_path, "wb");
+    int ok = file != NULL;
+    if (ok) {
+        static const char padding[8] = {0};
+        size_t pad = header.levels_offset - sizeof(header) - header.path_length;
+        ok = fwrite(&header, sizeof(header), 1, file) == 1 &&
+             fwrite(job->filename, 1, header.path_length, file) == header.path_length &&
+             fwrite(padding, 1, pad, file) == pad;
+        for (int level = 0; ok && level < peaks->level_count; level++) {
+            size_t count = (size_t)peaks->counts[level] * peaks->channels;
+            ok = fwrite(peaks->levels[level], sizeof(PeakValue), count, file) == count;
+        }
+        if (fclose(file) != 0) ok = 0;
+    }
+
+    if (ok) {
+#ifdef _WIN32
+        remove(path);
+#endif
+        ok = rename(temp_path, path) == 0;
+    }
+    if (ok) {
+        prune_cache(builder, path);
+    } else {
+        printf("Não foi possível gravar o cache da waveform em %s\n", path);
+        remove(temp_path);
+    }
+
+    free(temp_path);
+    free(path);
+}
+
+/* Tira o job da fila; o builder precisa estar travado. */
+static void unlink_job(PeakBuilder* builder, PeakJob* job) {
+    PeakJob* previous = NULL;
+    for (PeakJob* iter = builder->first; iter; previous = iter, iter = iter->next) {
+        if (iter != job) continue;
+        if (previous) previous->next = job->next;
+        else builder->first = job->next;
+        if (builder->last == job) builder->last = previous;
+        job->next = NULL;
+        return;
+    }
+}
+
+static void* peak_worker(void* arg) {
+    PeakBuilder* builder = (PeakBuilder*)arg;
+    uint8_t* raw = NULL;
+    float* samples = NULL;
+    size_t raw_size = 0, samples_size = 0;
+
+    pthread_mutex_lock(&builder->lock);
+    for (;;) {
+        while (!builder->quit && !builder->first) {
+            pthread_cond_wait(&builder->wake, &builder->lock);
+        }
+        if (builder->quit) break;
+
+        PeakJob* job = builder->first;
+        PeakPyramid* peaks = job->peaks;
+        uint64_t block = job->next_block++;
+        if (job->next_block >= peaks->block_count) unlink_job(builder, job);
+        job->users++;
+        pthread_mutex_unlock(&builder->lock);
+
+        size_t need_raw = (size_t)PEAK_BLOCK_FRAMES * job->reader.block_align;
+        size_t need_samples = (size_t)PEAK_BLOCK_FRAMES * job->reader.info.num_channels * sizeof(float);
+        if (need_raw > raw_size) {
+            free(raw);
+            raw = malloc(need_raw);
+            raw_size = raw ? need_raw : 0;
+        }
+        if (need_samples > samples_size) {
+            free(samples);
+            samples = malloc(need_samples);
+            samples_size = samples ? need_samples : 0;
+        }
+
+        if (raw && samples) {
+            compute_block(peaks, &job->reader, block, raw, samples);
+        } else {
+            printf("Erro ao alocar memória para a waveform\n");
+        }
+
+        /* Quem termina o último bloco monta o resto e fecha o arquivo. */
+        if (atomic_fetch_add(&peaks->blocks_done, 1) + 1 == peaks->block_count) {
+            finish_pyramid(peaks);
+            if (job->cacheable) save_cache(builder, job, peaks);
+            wav_reader_close(&job->reader);
+        }
+        if (builder->progress) {
+            builder->progress(builder->user);
+        }
+
+        pthread_mutex_lock(&builder->lock);
+        job->users--;
+        pthread_cond_broadcast(&builder->idle);
+    }
+    pthread_mutex_unlock(&builder->lock);
+
+    free(raw);
+    free(samples);
+    return NULL;
+}
+
+/*
+ * Cria uma thread por núcleo. progress é chamada de uma dessas threads a cada
+ * bloco publicado; quem usa o GTK deve só agendar o redesenho a partir dela.
+ * Pirâmides completas são guardadas em cache_dir (NULL desliga o cache).
+ */
+PeakBuilder* peak_builder_create(const char* cache_dir, void (*progress)(void* user), void* user) {
+    PeakBuilder* builder = calloc(1, sizeof(PeakBuilder));
+    if (!builder) return NULL;
+    if (cache_dir) builder->cache_dir = strdup(cache_dir);
+
+    pthread_mutex_init(&builder->lock, NULL);
+    pthread_cond_init(&builder->wake, NULL);
+    pthread_cond_init(&builder->idle, NULL);
+    builder->progress = progress;
+    builder->user = user;
+
+    int thread_count = peak_thread_count();
+    builder->threads = malloc(thread_count * sizeof(pthread_t));
+    if (builder->threads) {
+        for (; builder->thread_count < thread_count; builder->thread_count++) {
+            if (pthread_create(&builder->threads[builder->thread_count], NULL, peak_worker, builder) != 0) break;
+        }
+    }
+    if (builder->thread_count == 0) {
+        printf("Erro ao criar as threads da waveform\n");
+        peak_builder_destroy(builder);
+        return NULL;
+    }
+
+    return builder;
+}
+
+static void free_job(PeakJob* job) {
+    free(job->filename);
+    free(job);
+}
+
+/*
+ * Abre o arquivo e põe a pirâmide na fila; devolve na hora, com a pirâmide
+ * ainda vazia (peak_pyramid_query() falha nos blocos que não ficaram prontos).
+ * Se o cache do arquivo ainda vale, a pirâmide já volta completa.
+ */
+PeakPyramid* peak_builder_add(PeakBuilder* builder, const char* filename) {
+    PeakJob* job = calloc(1, sizeof(PeakJob));
+    PeakPyramid* peaks = calloc(1, sizeof(PeakPyramid));
+    if (!job || !peaks || open_peak_reader(&job->reader, filename) != 0) {
+        free(job);
+        free(peaks);
+        return NULL;
+    }
+    job->filename = strdup(filename);
+    if (!job->filename || peak_pyramid_init(peaks, &job->reader) != 0) {
+        wav_reader_close(&job->reader);
+        free_job(job);
+        free(peaks);
+        return NULL;
+    }
+
+    /* Sem como reconhecer o arquivo depois, o resultado não vai para o cache. */
+    job->cacheable = builder->cache_dir && file_identity(filename, &job->identity) == 0;
+    if (job->cacheable && load_cache(builder, job, peaks) == 0) {
+        wav_reader_close(&job->reader);
+        free_job(job);
+        return peaks;
+    }
+
+    job->peaks = peaks;
+    peaks->job = job;
+
+    pthread_mutex_lock(&builder->lock);
+    if (builder->last) builder->last->next = job;
+    else builder->first = job;
+    builder->last = job;
+    pthread_cond_broadcast(&builder->wake);
+    pthread_mutex_unlock(&builder->lock);
+
+    return peaks;
+}
+
+/* Cancela o que faltar calcular, espera as threads largarem a pirâmide e a libera. */
+void peak_builder_remove(PeakBuilder* builder, PeakPyramid* peaks) {
+    PeakJob* job = peaks->job;
+
+    if (job) {
+        pthread_mutex_lock(&builder->lock);
+        unlink_job(builder, job);
+        while (job->users > 0) {
+            pthread_cond_wait(&builder->idle, &builder->lock);
+        }
+        pthread_mutex_unlock(&builder->lock);
+
+        if (!atomic_load(&peaks->complete)) {
+            wav_reader_close(&job->reader);
+        }
+        free_job(job);
+    }
+
+    peak_pyramid_free(peaks);
+    free(peaks);
+}
+
+/* As pirâmides ainda na fila devem ter sido removidas antes. */
+void peak_builder_destroy(PeakBuilder* builder) {
+    if (!builder) return;
+
+    pthread_mutex_lock(&builder->lock);
+    builder->quit = 1;
+    pthread_cond_broadcast(&builder->wake);
+    pthread_mutex_unlock(&builder->lock);
+
+    for (int i = 0; i < builder->thread_count; i++) {
+        pthread_join(builder->threads[i], NULL);
+    }
+
+    pthread_cond_destroy(&builder->idle);
+    pthread_cond_destroy(&builder->wake);
+    pthread_mutex_destroy(&builder->lock);
+    free(builder->threads);
+    free(builder->cache_dir);
+    free(builder);
+}
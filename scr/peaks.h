@@ -0,0 +1,83 @@
+#ifndef PEAKS_H
+#define PEAKS_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdatomic.h>
+#include "wav_reader.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Quadros resumidos por pico no nível 0; cada nível acima junta dois picos do
+ * nível de baixo (512, 1024, ... quadros por pico).
+ */
+#define PEAK_BASE_FRAMES 256
+#define PEAK_MAX_LEVELS 24
+
+/*
+ * O arquivo é analisado em blocos independentes de PEAK_BLOCK_FRAMES quadros;
+ * cada bloco já monta os níveis 1 a PEAK_BLOCK_LEVELS da sua parte.
+ */
+#define PEAK_BLOCK_LEVELS 8
+#define PEAK_BLOCK_FRAMES (PEAK_BASE_FRAMES << PEAK_BLOCK_LEVELS)
+
+/* Canais com picos próprios; num arquivo multicanal, só os primeiros (L e R). */
+#define PEAK_MAX_CHANNELS 2
+
+/* Mínimo, máximo e RMS de um trecho, na escala de 16 bits. */
+typedef struct {
+    int16_t min;
+    int16_t max;
+    int16_t rms;
+} PeakValue;
+
+typedef struct PeakJob PeakJob;
+
+/*
+ * Pirâmide de picos de um arquivo, com um pico por canal (até
+ * PEAK_MAX_CHANNELS). O nível k tem counts[k] posições de PEAK_BASE_FRAMES << k
+ * quadros, e cada posição guarda "channels" picos seguidos, um de cada canal;
+ * o último nível tem uma posição só.
+ * Enquanto é calculada em segundo plano, block_ready marca os blocos prontos
+ * e só os níveis de dentro dos blocos valem; complete libera os outros.
+ * Vinda do cache em disco, os níveis apontam para o arquivo mapeado (map_base).
+ */
+typedef struct {
+    uint64_t frames;
+    uint32_t sample_rate;
+    int channels;
+    int level_count;
+    uint64_t counts[PEAK_MAX_LEVELS];
+    PeakValue* levels[PEAK_MAX_LEVELS];
+    _Atomic int max_abs;
+    uint64_t block_count;
+    _Atomic uint8_t* block_ready;
+    _Atomic uint64_t blocks_done;
+    _Atomic int complete;
+    PeakJob* job;
+    void* map_base;
+    size_t map_length;
+    void* map_handle;
+} PeakPyramid;
+
+/* Threads que calculam pirâmides em segundo plano, ver peak_builder_add(). */
+typedef struct PeakBuilder PeakBuilder;
+
+void peak_pyramid_free(PeakPyramid* peaks);
+int peak_pyramid_query(const PeakPyramid* peaks, uint64_t first_frame, uint64_t end_frame, PeakValue* result);
+float peak_pyramid_progress(const PeakPyramid* peaks);
+int peak_read_range(const WavReader* reader, uint64_t first_frame, uint64_t end_frame, PeakValue* result);
+
+PeakBuilder* peak_builder_create(const char* cache_dir, void (*progress)(void* user), void* user);
+PeakPyramid* peak_builder_add(PeakBuilder* builder, const char* filename);
+void peak_builder_remove(PeakBuilder* builder, PeakPyramid* peaks);
+void peak_builder_destroy(PeakBuilder* builder);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
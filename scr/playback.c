@@ -0,0 +1,279 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <time.h>
+#endif
+#include "playback.h"
+
+#define PLAYBACK_RING_MASK (PLAYBACK_RING_FRAMES - 1)
+#define PLAYBACK_QUEUE_MASK (PLAYBACK_QUEUE_SIZE - 1)
+#define PLAYBACK_SEEK_QUEUE_MASK (PLAYBACK_SEEK_QUEUE_SIZE - 1)
+
+/* Espera o callback liberar espaço no anel (~1 ms, bem menos que um pedaço). */
+static void playback_wait(void) {
+#ifdef _WIN32
+    Sleep(1);
+#else
+    struct timespec delay = { 0, 1000000 };
+    nanosleep(&delay, NULL);
+#endif
+}
+
+/*
+ * Renderiza o próximo pedaço no anel se houver espaço. Devolve 1 se escreveu,
+ * 0 se o anel está cheio e -1 se a linha do tempo acabou.
+ */
+static int render_chunk(PlaybackEngine* engine) {
+    uint64_t write_pos = atomic_load_explicit(&engine->write_pos, memory_order_relaxed);
+    uint64_t read_pos = atomic_load_explicit(&engine->read_pos, memory_order_acquire);
+    uint64_t frame = engine->first_frame + (write_pos - engine->render_start);
+    if (frame >= engine->end_frame) return -1;
+
+    size_t space = PLAYBACK_RING_FRAMES - (size_t)(write_pos - read_pos);
+    if (space < PLAYBACK_CHUNK_FRAMES) return 0;
+
+    /* Um pedaço nunca atravessa o fim do anel. */
+    size_t offset = (size_t)(write_pos & PLAYBACK_RING_MASK);
+    size_t frames = PLAYBACK_CHUNK_FRAMES;
+    if (frames > PLAYBACK_RING_FRAMES - offset) frames = PLAYBACK_RING_FRAMES - offset;
+    if (frames > engine->end_frame - frame) frames = (size_t)(engine->end_frame - frame);
+
+    mix_stream_render(engine->stream, frame, engine->ring + offset * engine->channels, frames);
+    atomic_store_explicit(&engine->write_pos, write_pos + frames, memory_order_release);
+    return 1;
+}
+
+/* Aplica as mudanças de ganho que o GTK enfileirou desde o último pedaço. */
+static void apply_gain_changes(PlaybackEngine* engine) {
+    uint32_t read = atomic_load_explicit(&engine->queue_read, memory_order_relaxed);
+    uint32_t write = atomic_load_explicit(&engine->queue_write, memory_order_acquire);
+
+    for (; read != write; read++) {
+        const PlaybackGainChange* change = &engine->queue[read & PLAYBACK_QUEUE_MASK];
+        mix_stream_set_gain(engine->stream, change->clip_index, change->volume, change->pan);
+    }
+
+    atomic_store_explicit(&engine->queue_read, read, memory_order_release);
+}
+
+/*
+ * Começa um trecho novo em write_pos: dali em diante a thread renderiza a
+ * partir de first_frame, "length" quadros (0 = até o fim). O que já está no
+ * anel fica lá até o callback ver o trecho novo e pular para segment_start.
+ */
+static void begin_segment(PlaybackEngine* engine, uint32_t generation, uint64_t first_frame, uint64_t length) {
+    engine->first_frame = first_frame;
+    engine->end_frame = engine->total_frames;
+    if (first_frame >= engine->total_frames) {
+        engine->end_frame = first_frame;
+    } else if (length > 0 && length < engine->total_frames - first_frame) {
+        engine->end_frame = first_frame + length;
+    }
+    engine->render_start = atomic_load_explicit(&engine->write_pos, memory_order_relaxed);
+
+    uint32_t sequence = atomic_load_explicit(&engine->segment_sequence, memory_order_relaxed);
+    atomic_store_explicit(&engine->segment_sequence, sequence + 1, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+    atomic_store_explicit(&engine->segment_start, engine->render_start, memory_order_relaxed);
+    atomic_store_explicit(&engine->segment_frame, first_frame, memory_order_relaxed);
+    atomic_store_explicit(&engine->segment_generation, generation, memory_order_relaxed);
+    atomic_store_explicit(&engine->segment_sequence, sequence + 2, memory_order_release);
+}
+
+/* Lado do callback: lê o trecho atual, esperando se a thread estiver no meio da troca. */
+static void read_segment(PlaybackEngine* engine, uint64_t* start, uint64_t* frame, uint32_t* generation) {
+    uint32_t before, after;
+    do {
+        before = atomic_load_explicit(&engine->segment_sequence, memory_order_acquire);
+        *start = atomic_load_explicit(&engine->segment_start, memory_order_relaxed);
+        *frame = atomic_load_explicit(&engine->segment_frame, memory_order_relaxed);
+        *generation = atomic_load_explicit(&engine->segment_generation, memory_order_relaxed);
+        atomic_thread_fence(memory_order_acquire);
+        after = atomic_load_explicit(&engine->segment_sequence, memory_order_relaxed);
+    } while (before != after || (before & 1));
+}
+
+/*
+ * Atende os seeks que o GTK enfileirou desde o último pedaço. Só o mais novo
+ * importa: os outros foram substituídos antes de a thread chegar a eles.
+ */
+static void apply_seeks(PlaybackEngine* engine) {
+    uint32_t read = atomic_load_explicit(&engine->seek_read, memory_order_relaxed);
+    uint32_t write = atomic_load_explicit(&engine->seek_write, memory_order_acquire);
+    if (read == write) return;
+
+    PlaybackSeek seek = engine->seeks[(write - 1) & PLAYBACK_SEEK_QUEUE_MASK];
+    atomic_store_explicit(&engine->seek_read, write, memory_order_release);
+    begin_segment(engine, seek.generation, seek.first_frame, seek.length);
+}
+
+/*
+ * Roda do start ao stop. No fim da linha do tempo (ou do grão) não sai: fica
+ * esperando o próximo seek.
+ */
+static void* playback_thread(void* arg) {
+    PlaybackEngine* engine = (PlaybackEngine*)arg;
+
+    while (atomic_load_explicit(&engine->running, memory_order_acquire)) {
+        apply_seeks(engine);
+        apply_gain_changes(engine);
+        if (render_chunk(engine) <= 0) playback_wait();
+    }
+
+    return NULL;
+}
+
+static void join_thread(PlaybackEngine* engine) {
+    atomic_store_explicit(&engine->running, 0, memory_order_release);
+    if (engine->thread_started) {
+        pthread_join(engine->thread, NULL);
+        engine->thread_started = 0;
+    }
+}
+
+/*
+ * Começa a tocar o stream a partir de first_frame. O engine passa a ser dono do
+ * stream (fechado em playback_engine_stop(), ou aqui mesmo se falhar).
+ */
+int playback_engine_start(PlaybackEngine* engine, MixStream* stream, uint64_t first_frame) {
+    engine->stream = stream;
+    engine->channels = mix_stream_channels(stream);
+    engine->sample_rate = mix_stream_sample_rate(stream);
+    engine->total_frames = mix_stream_frames(stream);
+    engine->thread_started = 0;
+    engine->seek_generation = 0;
+    engine->seek_frame = first_frame;
+    atomic_store(&engine->running, 0);
+    atomic_store(&engine->write_pos, 0);
+    atomic_store(&engine->read_pos, 0);
+    atomic_store(&engine->queue_write, 0);
+    atomic_store(&engine->queue_read, 0);
+    atomic_store(&engine->seek_write, 0);
+    atomic_store(&engine->seek_read, 0);
+    atomic_store(&engine->segment_sequence, 0);
+    atomic_store(&engine->played_frame, first_frame);
+    atomic_store(&engine->played_generation, 0);
+
+    engine->ring = malloc((size_t)PLAYBACK_RING_FRAMES * engine->channels * sizeof(int16_t));
+    if (!engine->ring) {
+        playback_engine_stop(engine);
+        return -1;
+    }
+
+    /* O primeiro pedaço vem antes da thread, para o primeiro callback já achar áudio. */
+    begin_segment(engine, 0, first_frame, 0);
+    render_chunk(engine);
+
+    atomic_store_explicit(&engine->running, 1, memory_order_release);
+    if (pthread_create(&engine->thread, NULL, playback_thread, engine) != 0) {
+        printf("Erro ao criar a thread de reprodução\n");
+        playback_engine_stop(engine);
+        return -1;
+    }
+    engine->thread_started = 1;
+    return 0;
+}
+
+/*
+ * Lado do GTK: pede para a reprodução pular para first_frame sem reabrir os
+ * clipes; com length > 0 toca só esse tanto de quadros (um grão do scrub) e
+ * depois fica em silêncio. Não trava nem espera: a thread atende o pedido
+ * antes do próximo pedaço e o callback descarta o que estava no anel. Devolve
+ * -1 se não está tocando ou se a fila estiver cheia.
+ */
+int playback_engine_seek(PlaybackEngine* engine, uint64_t first_frame, uint64_t length) {
+    if (!atomic_load_explicit(&engine->running, memory_order_acquire)) return -1;
+
+    uint32_t write = atomic_load_explicit(&engine->seek_write, memory_order_relaxed);
+    uint32_t read = atomic_load_explicit(&engine->seek_read, memory_order_acquire);
+    if (write - read >= PLAYBACK_SEEK_QUEUE_SIZE) return -1;
+
+    PlaybackSeek* seek = &engine->seeks[write & PLAYBACK_SEEK_QUEUE_MASK];
+    seek->generation = ++engine->seek_generation;
+    seek->first_frame = first_frame;
+    seek->length = length;
+    engine->seek_frame = first_frame;
+    atomic_store_explicit(&engine->seek_write, write + 1, memory_order_release);
+    return 0;
+}
+
+/* Para a thread e libera o anel e o stream; o callback não pode estar rodando. */
+void playback_engine_stop(PlaybackEngine* engine) {
+    join_thread(engine);
+
+    free(engine->ring);
+    engine->ring = NULL;
+    mix_stream_close(engine->stream);
+    engine->stream = NULL;
+}
+
+/*
+ * Lado do GTK: pede um novo volume/pan para o clipe clip_index (posição na
+ * lista passada a mix_stream_open()). Não trava; devolve -1 se não está
+ * tocando ou se a fila estiver cheia.
+ */
+int playback_engine_set_gain(PlaybackEngine* engine, int clip_index, float volume, float pan) {
+    if (!atomic_load_explicit(&engine->running, memory_order_acquire)) return -1;
+
+    uint32_t write = atomic_load_explicit(&engine->queue_write, memory_order_relaxed);
+    uint32_t read = atomic_load_explicit(&engine->queue_read, memory_order_acquire);
+    if (write - read >= PLAYBACK_QUEUE_SIZE) return -1;
+
+    PlaybackGainChange* change = &engine->queue[write & PLAYBACK_QUEUE_MASK];
+    change->clip_index = clip_index;
+    change->volume = volume;
+    change->pan = pan;
+    atomic_store_explicit(&engine->queue_write, write + 1, memory_order_release);
+    return 0;
+}
+
+/*
+ * Lado do callback de áudio: copia até "frames" quadros do anel para output e
+ * devolve quantos copiou. Nunca trava nem mixa; se o anel estiver vazio o
+ * resto fica por conta de quem chamou (silêncio).
+ */
+size_t playback_engine_read(PlaybackEngine* engine, int16_t* output, size_t frames) {
+    if (!atomic_load_explicit(&engine->running, memory_order_acquire)) return 0;
+
+    /* O que está antes do trecho atual é de antes de um seek: fica sem tocar. */
+    uint64_t segment_start, segment_frame;
+    uint32_t generation;
+    read_segment(engine, &segment_start, &segment_frame, &generation);
+    uint64_t read_pos = atomic_load_explicit(&engine->read_pos, memory_order_relaxed);
+    if (read_pos < segment_start) read_pos = segment_start;
+
+    uint64_t write_pos = atomic_load_explicit(&engine->write_pos, memory_order_acquire);
+    size_t available = (size_t)(write_pos - read_pos);
+    size_t count = available < frames ? available : frames;
+
+    size_t offset = (size_t)(read_pos & PLAYBACK_RING_MASK);
+    size_t first_part = PLAYBACK_RING_FRAMES - offset;
+    if (first_part > count) first_part = count;
+    size_t frame_bytes = engine->channels * sizeof(int16_t);
+
+    memcpy(output, engine->ring + offset * engine->channels, first_part * frame_bytes);
+    memcpy(output + first_part * engine->channels, engine->ring, (count - first_part) * frame_bytes);
+
+    atomic_store_explicit(&engine->read_pos, read_pos + count, memory_order_release);
+    atomic_store_explicit(&engine->played_frame, segment_frame + (read_pos + count - segment_start),
+                          memory_order_relaxed);
+    atomic_store_explicit(&engine->played_generation, generation, memory_order_release);
+    return count;
+}
+
+/*
+ * Quadro da linha do tempo que o callback já entregou ao dispositivo e, em
+ * generation (se não for NULL), de qual seek ele é: enquanto for menor que
+ * seek_generation, o dispositivo ainda não tocou nada do último pedido.
+ */
+uint64_t playback_engine_position(PlaybackEngine* engine, uint32_t* generation) {
+    if (generation) *generation = atomic_load_explicit(&engine->played_generation, memory_order_acquire);
+    return atomic_load_explicit(&engine->played_frame, memory_order_relaxed);
+}
+
+int playback_engine_finished(PlaybackEngine* engine) {
+    return !engine->stream || playback_engine_position(engine, NULL) >= engine->total_frames;
+}
@@ -0,0 +1,104 @@
+#ifndef PLAYBACK_H
+#define PLAYBACK_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdatomic.h>
+#include <pthread.h>
+#include "wav_reader.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Tamanho do anel em quadros (potência de 2) e de cada pedaço renderizado. O
+ * anel também é o atraso máximo até uma mudança de volume/pan ser ouvida.
+ */
+#define PLAYBACK_RING_FRAMES 8192
+#define PLAYBACK_CHUNK_FRAMES 1024
+
+/* Mudanças de ganho e pedidos de seek pendentes (potências de 2). */
+#define PLAYBACK_QUEUE_SIZE 64
+#define PLAYBACK_SEEK_QUEUE_SIZE 16
+
+/* Novo volume/pan de um clipe, da thread do GTK para a de reprodução. */
+typedef struct {
+    int clip_index;
+    float volume;
+    float pan;
+} PlaybackGainChange;
+
+/* Pedido de seek (ou grão do scrub), da thread do GTK para a de reprodução. */
+typedef struct {
+    uint32_t generation;
+    uint64_t first_frame;
+    uint64_t length;        /* 0 = até o fim */
+} PlaybackSeek;
+
+/*
+ * Reprodução com uma thread de renderização: ela mixa o MixStream à frente e
+ * escreve num anel de quadros em 16 bits; o callback de áudio só copia do anel.
+ * O anel é de um produtor e um consumidor, sem trava: write_pos só é escrito
+ * pela thread e read_pos só pelo callback, e cada lado lê o do outro com
+ * acquire. Posições contam quadros desde o start, sem dar a volta.
+ * As filas de mudanças de ganho e de seeks seguem a mesma regra no sentido
+ * contrário: o GTK escreve, a thread de reprodução aplica antes de cada pedaço.
+ *
+ * Um seek não esvazia o anel: a thread começa um trecho novo em write_pos e o
+ * publica (segment_*) com a geração do pedido. O callback pula o que ficou
+ * antes de segment_start e informa a geração do que entregou, para o GTK
+ * ignorar posições de antes do último pedido. A thread vive do start ao stop.
+ */
+typedef struct {
+    MixStream* stream;
+    int16_t* ring;
+    uint16_t channels;
+    uint32_t sample_rate;
+    uint64_t total_frames;
+
+    /* Só da thread de reprodução: o trecho que ela está renderizando. */
+    uint64_t first_frame;   /* quadro da linha do tempo em segment_start */
+    uint64_t end_frame;     /* renderiza até aqui (total_frames, ou o fim do grão) */
+    uint64_t render_start;  /* posição do anel onde o trecho começa */
+
+    /* Trecho atual para o callback; segment_sequence é ímpar durante a troca. */
+    _Atomic uint32_t segment_sequence;
+    _Atomic uint64_t segment_start;
+    _Atomic uint64_t segment_frame;
+    _Atomic uint32_t segment_generation;
+
+    /* Escritos pelo callback: até onde entregou e de qual geração. */
+    _Atomic uint64_t played_frame;
+    _Atomic uint32_t played_generation;
+
+    /* Só do GTK: último seek pedido. */
+    uint32_t seek_generation;
+    uint64_t seek_frame;
+
+    _Atomic uint64_t write_pos;
+    _Atomic uint64_t read_pos;
+    _Atomic int running;
+    PlaybackGainChange queue[PLAYBACK_QUEUE_SIZE];
+    _Atomic uint32_t queue_write;
+    _Atomic uint32_t queue_read;
+    PlaybackSeek seeks[PLAYBACK_SEEK_QUEUE_SIZE];
+    _Atomic uint32_t seek_write;
+    _Atomic uint32_t seek_read;
+    pthread_t thread;
+    int thread_started;
+} PlaybackEngine;
+
+int playback_engine_start(PlaybackEngine* engine, MixStream* stream, uint64_t first_frame);
+void playback_engine_stop(PlaybackEngine* engine);
+int playback_engine_seek(PlaybackEngine* engine, uint64_t first_frame, uint64_t length);
+int playback_engine_set_gain(PlaybackEngine* engine, int clip_index, float volume, float pan);
+size_t playback_engine_read(PlaybackEngine* engine, int16_t* output, size_t frames);
+uint64_t playback_engine_position(PlaybackEngine* engine, uint32_t* generation);
+int playback_engine_finished(PlaybackEngine* engine);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
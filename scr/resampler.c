@@ -0,0 +1,154 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <math.h>
+#include "resampler.h"
+
+typedef struct {
+    uint32_t taps;
+    double beta;
+    double rolloff;
+} ResampleProfile;
+
+/* Coeficientes por fase, parâmetro da janela de Kaiser e fração da banda útil mantida. */
+static const ResampleProfile resample_profiles[] = {
+    { 16, 6.0, 0.85 },
+    { 32, 8.0, 0.91 },
+    { 64, 10.0, 0.95 }
+};
+
+static uint32_t gcd_u32(uint32_t a, uint32_t b) {
+    while (b != 0) {
+        uint32_t t = a % b;
+        a = b;
+        b = t;
+    }
+    return a;
+}
+
+/* Função de Bessel modificada de ordem zero, pela série de potências. */
+static double bessel_i0(double x) {
+    double sum = 1.0;
+    double term = 1.0;
+    for (int k = 1; k < 50; k++) {
+        term *= (x / (2.0 * k)) * (x / (2.0 * k));
+        sum += term;
+        if (term < sum * 1e-12) break;
+    }
+    return sum;
+}
+
+int resampler_init(Resampler* resampler, uint32_t in_rate, uint32_t out_rate, ResampleQuality quality) {
+    if (!resampler || in_rate == 0 || out_rate == 0) return -1;
+    memset(resampler, 0, sizeof(Resampler));
+
+    if (quality < RESAMPLE_FAST || quality > RESAMPLE_BEST) quality = RESAMPLE_MEDIUM;
+    const ResampleProfile* profile = &resample_profiles[quality];
+
+    uint32_t divisor = gcd_u32(in_rate, out_rate);
+    resampler->in_rate = in_rate;
+    resampler->out_rate = out_rate;
+    resampler->up = out_rate / divisor;
+    resampler->down = in_rate / divisor;
+    resampler->phase_count = resampler->up < RESAMPLER_MAX_PHASES ? resampler->up : RESAMPLER_MAX_PHASES;
+
+    /* Na redução de taxa o corte desce junto, e o filtro cresce para manter a transição. */
+    double ratio = (double)resampler->up / resampler->down;
+    double cutoff = 0.5 * profile->rolloff * (ratio < 1.0 ? ratio : 1.0);
+    uint32_t taps = profile->taps;
+    if (ratio < 1.0) {
+        taps = (uint32_t)ceil(profile->taps / ratio);
+        taps = (taps + 15) & ~15u;
+        if (taps > 512) taps = 512;
+    }
+    resampler->taps = taps;
+
+    resampler->filters = malloc((size_t)resampler->phase_count * taps * sizeof(float));
+    if (!resampler->filters) return -1;
+
+    double half = taps / 2.0;
+    double window_norm = bessel_i0(profile->beta);
+    for (uint32_t phase = 0; phase < resampler->phase_count; phase++) {
+        float* filter = resampler->filters + (size_t)phase * taps;
+        double frac = (double)phase / resampler->phase_count;
+        double sum = 0.0;
+        double coefficients[512];
+
+        for (uint32_t k = 0; k < taps; k++) {
+            double distance = (double)k - half + 1.0 - frac;
+            double x = distance / half;
+            double window = (x >= -1.0 && x <= 1.0) ? bessel_i0(profile->beta * sqrt(1.0 - x * x)) / window_norm : 0.0;
+            double arg = 2.0 * cutoff * distance;
+            double sinc = (fabs(arg) < 1e-9) ? 1.0 : sin(M_PI * arg) / (M_PI * arg);
+            coefficients[k] = sinc * window;
+            sum += coefficients[k];
+        }
+
+        /* Ganho unitário em DC em todas as fases. */
+        for (uint32_t k = 0; k < taps; k++) {
+            filter[k] = (float)(coefficients[k] / sum);
+        }
+    }
+
+    return 0;
+}
+
+void resampler_free(Resampler* resampler) {
+    if (!resampler) return;
+    free(resampler->filters);
+    memset(resampler, 0, sizeof(Resampler));
+}
+
+uint64_t resampler_output_frames(const Resampler* resampler, uint64_t input_frames) {
+    return (input_frames * resampler->up + resampler->down - 1) / resampler->down;
+}
+
+/* Maior trecho de entrada que resampler_input_span() pode pedir para "output_frames" quadros. */
+size_t resampler_max_span(const Resampler* resampler, size_t output_frames) {
+    if (output_frames == 0) return 0;
+    return (size_t)(((uint64_t)(output_frames - 1) * resampler->down) / resampler->up) + resampler->taps + 1;
+}
+
+void resampler_input_span(const Resampler* resampler, uint64_t first_output, size_t output_frames,
+                          int64_t* first_input, size_t* input_frames) {
+    int64_t half = resampler->taps / 2;
+    int64_t first_base = (int64_t)((first_output * resampler->down) / resampler->up);
+    int64_t last_base = first_base;
+    if (output_frames > 0) {
+        last_base = (int64_t)(((first_output + output_frames - 1) * resampler->down) / resampler->up);
+    }
+    *first_input = first_base - half + 1;
+    *input_frames = (size_t)(last_base + half - *first_input + 1);
+}
+
+/*
+ * Gera "output_frames" quadros de um canal a partir de "first_output".
+ * "input" é o trecho planar do mesmo canal que começa no quadro
+ * "first_input", como devolvido por resampler_input_span().
+ */
+void resampler_process(const Resampler* resampler, const MixKernels* kernels, const float* input, int64_t first_input,
+                       uint64_t first_output, size_t output_frames, float* output, size_t output_stride) {
+    uint32_t taps = resampler->taps;
+    uint32_t up = resampler->up;
+    uint32_t step_base = resampler->down / up;
+    uint32_t step_frac = resampler->down % up;
+
+    uint64_t position = first_output * resampler->down;
+    int64_t base = (int64_t)(position / up);
+    uint32_t frac = (uint32_t)(position % up);
+    const float* window = input + (base - taps / 2 + 1 - first_input);
+
+    for (size_t j = 0; j < output_frames; j++) {
+        uint32_t phase = (resampler->phase_count == up) ? frac
+                         : (uint32_t)(((uint64_t)frac * resampler->phase_count) / up);
+        output[j * output_stride] = kernels->dot_f32(resampler->filters + (size_t)phase * taps, window, taps);
+
+        window += step_base;
+        frac += step_frac;
+        if (frac >= up) {
+            frac -= up;
+            window++;
+        }
+    }
+}
@@ -0,0 +1,45 @@
+#ifndef RESAMPLER_H
+#define RESAMPLER_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "wav_reader.h"
+#include "mix_kernels.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define RESAMPLER_MAX_PHASES 1024
+
+/*
+ * Conversor de taxa polifásico com sinc janelado (Kaiser). A razão
+ * out_rate/in_rate é reduzida para up/down; a saída n fica na posição de
+ * entrada n * down / up, e cada fase do banco tem "taps" coeficientes.
+ * O banco é só leitura depois de resampler_init(), então várias threads podem
+ * usar o mesmo Resampler, cada uma com o seu trecho de entrada.
+ */
+typedef struct {
+    uint32_t in_rate;
+    uint32_t out_rate;
+    uint32_t up;
+    uint32_t down;
+    uint32_t phase_count;
+    uint32_t taps;
+    float* filters;
+} Resampler;
+
+int resampler_init(Resampler* resampler, uint32_t in_rate, uint32_t out_rate, ResampleQuality quality);
+void resampler_free(Resampler* resampler);
+uint64_t resampler_output_frames(const Resampler* resampler, uint64_t input_frames);
+size_t resampler_max_span(const Resampler* resampler, size_t output_frames);
+void resampler_input_span(const Resampler* resampler, uint64_t first_output, size_t output_frames,
+                          int64_t* first_input, size_t* input_frames);
+void resampler_process(const Resampler* resampler, const MixKernels* kernels, const float* input, int64_t first_input,
+                       uint64_t first_output, size_t output_frames, float* output, size_t output_stride);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
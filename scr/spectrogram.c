@@ -0,0 +1,642 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <pthread.h>
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <unistd.h>
+#endif
+#include "spectrogram.h"
+#include "mix_kernels.h"
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+#define SPECTROGRAM_BINS (SPECTROGRAM_FFT_SIZE / 2)
+
+/* Nível cujas colunas têm SPECTROGRAM_FFT_SIZE quadros; acima dele nenhuma FFT nova. */
+#define SPECTROGRAM_FFT_LEVEL 11
+#if (1 << SPECTROGRAM_FFT_LEVEL) != SPECTROGRAM_FFT_SIZE
+#error "SPECTROGRAM_FFT_LEVEL não corresponde a SPECTROGRAM_FFT_SIZE"
+#endif
+
+/* Intensidade mostrada, de SPECTROGRAM_FLOOR_DB (preto) até 0 dB (um seno em escala cheia). */
+#define SPECTROGRAM_FLOOR_DB -120.0f
+
+typedef enum {
+    TILE_FREE = 0,
+    TILE_QUEUED,
+    TILE_COMPUTING,
+    TILE_READY
+} TileState;
+
+/* Estado de um bloco de Spectrogram.fft_columns. */
+enum {
+    FFT_BLOCK_MISSING = 0,
+    FFT_BLOCK_COMPUTING,
+    FFT_BLOCK_READY
+};
+
+/*
+ * Uma vaga do cache. pixels (ARGB32, SPECTROGRAM_TILE_COLUMNS por linha) fica
+ * alocado com a vaga e é reaproveitado pelo próximo ladrilho.
+ */
+typedef struct SpectrogramTile {
+    Spectrogram* owner;
+    int level;
+    uint64_t index;
+    TileState state;
+    uint64_t last_used;
+    uint32_t* pixels;
+    struct SpectrogramTile* next;   /* na pilha de pedidos */
+} SpectrogramTile;
+
+/*
+ * Cache de ladrilhos e as threads que os calculam. Os pedidos formam uma
+ * pilha: o último pedido (o que acabou de aparecer na tela) sai primeiro.
+ * Só a thread do GTK escolhe vagas e descarta ladrilhos; as threads só passam
+ * um ladrilho de TILE_COMPUTING para TILE_READY, então os pixels de um
+ * ladrilho pronto não mudam enquanto o GTK desenha.
+ */
+struct SpectrogramEngine {
+    pthread_mutex_t lock;
+    pthread_cond_t wake;
+    pthread_cond_t idle;
+    SpectrogramTile tiles[SPECTROGRAM_CACHE_TILES];
+    SpectrogramTile* pending;
+    Spectrogram* spectrograms;
+    uint64_t clock;
+    pthread_t* threads;
+    int thread_count;
+    int quit;
+    void (*progress)(void* user);
+    void* user;
+
+    /* Tabelas da FFT: os fatores do estágio de metade h começam em h - 1. */
+    float window[SPECTROGRAM_FFT_SIZE];
+    float twiddle_re[SPECTROGRAM_FFT_SIZE];
+    float twiddle_im[SPECTROGRAM_FFT_SIZE];
+    uint16_t reverse[SPECTROGRAM_FFT_SIZE];
+    uint32_t palette[256];
+};
+
+/*
+ * Estado de uma thread: a janela lida por último (o mesmo trecho serve aos
+ * dois canais), a janela que espera um par para a FFT e a potência de cada
+ * linha das colunas do ladrilho.
+ */
+typedef struct {
+    uint8_t* raw;
+    float* samples;
+    size_t raw_size;
+    size_t samples_size;
+    const Spectrogram* loaded_owner;
+    int64_t loaded_first;
+    int pending_column;
+    float re[SPECTROGRAM_FFT_SIZE];
+    float im[SPECTROGRAM_FFT_SIZE];
+    float rows[SPECTROGRAM_TILE_COLUMNS * SPECTROGRAM_TILE_ROWS];
+} SpectrogramWorker;
+
+static int spectrogram_thread_count(void) {
+#ifdef _WIN32
+    SYSTEM_INFO system_info;
+    GetSystemInfo(&system_info);
+    long count = system_info.dwNumberOfProcessors;
+#else
+    long count = sysconf(_SC_NPROCESSORS_ONLN);
+#endif
+    return count > 0 ? (int)count : 1;
+}
+
+/* Janela de Hann, fatores e permutação de bits da FFT, e a paleta de cores. */
+static void init_tables(SpectrogramEngine* engine) {
+    int bits = 0;
+    while ((1 << bits) < SPECTROGRAM_FFT_SIZE) bits++;
+
+    for (int i = 0; i < SPECTROGRAM_FFT_SIZE; i++) {
+        engine->window[i] = (float)(0.5 - 0.5 * cos(2 * M_PI * i / SPECTROGRAM_FFT_SIZE));
+        int reversed = 0;
+        for (int bit = 0; bit < bits; bit++) {
+            if (i & (1 << bit)) reversed |= 1 << (bits - 1 - bit);
+        }
+        engine->reverse[i] = (uint16_t)reversed;
+    }
+
+    for (int half = 1; half < SPECTROGRAM_FFT_SIZE; half *= 2) {
+        for (int j = 0; j < half; j++) {
+            engine->twiddle_re[half - 1 + j] = (float)cos(M_PI * j / half);
+            engine->twiddle_im[half - 1 + j] = (float)-sin(M_PI * j / half);
+        }
+    }
+
+    /* Preto, azul, roxo, laranja e amarelo claro, em trechos iguais. */
+    static const float stops[5][3] = {
+        { 0.0f, 0.0f, 0.0f }, { 0.1f, 0.05f, 0.45f }, { 0.6f, 0.1f, 0.5f }, { 0.95f, 0.45f, 0.1f }, { 1.0f, 1.0f, 0.75f }
+    };
+    for (int i = 0; i < 256; i++) {
+        float position = i / 255.0f * 4;
+        int stop = position < 4 ? (int)position : 3;
+        float t = position - stop;
+        uint32_t pixel = 0xFF000000u;
+        for (int c = 0; c < 3; c++) {
+            float value = stops[stop][c] + (stops[stop + 1][c] - stops[stop][c]) * t;
+            pixel |= (uint32_t)(value * 255 + 0.5f) << (16 - 8 * c);
+        }
+        engine->palette[i] = pixel;
+    }
+}
+
+/*
+ * Nível dos ladrilhos para frames_per_pixel quadros por pixel: o mais grosso
+ * cujas colunas ainda cabem num pixel. De perto fica em SPECTROGRAM_MIN_LEVEL
+ * e as colunas são esticadas.
+ */
+int spectrogram_level(double frames_per_pixel) {
+    int level = SPECTROGRAM_MIN_LEVEL;
+    while (level < SPECTROGRAM_MAX_LEVEL && (double)((uint64_t)1 << (level + 1)) <= frames_per_pixel) {
+        level++;
+    }
+    return level;
+}
+
+/* Garante que os buffers da thread comportam uma janela do arquivo de spectrogram. */
+static int reserve_buffers(SpectrogramWorker* worker, const Spectrogram* spectrogram) {
+    size_t need_raw = (size_t)SPECTROGRAM_FFT_SIZE * spectrogram->reader.block_align;
+    size_t need_samples = (size_t)SPECTROGRAM_FFT_SIZE * spectrogram->reader.info.num_channels * sizeof(float);
+    if (need_raw > worker->raw_size) {
+        free(worker->raw);
+        worker->raw = malloc(need_raw);
+        worker->raw_size = worker->raw ? need_raw : 0;
+    }
+    if (need_samples > worker->samples_size) {
+        free(worker->samples);
+        worker->samples = malloc(need_samples);
+        worker->samples_size = worker->samples ? need_samples : 0;
+    }
+    worker->loaded_owner = NULL;
+    return worker->raw && worker->samples ? 0 : -1;
+}
+
+/* Lê os quadros [first, first + SPECTROGRAM_FFT_SIZE) em float; o que cai fora do arquivo vira zero. */
+static void load_window(SpectrogramWorker* worker, const Spectrogram* spectrogram, int64_t first) {
+    if (worker->loaded_owner == spectrogram && worker->loaded_first == first) return;
+
+    const WavReader* reader = &spectrogram->reader;
+    uint16_t stride = reader->info.num_channels;
+    memset(worker->samples, 0, (size_t)SPECTROGRAM_FFT_SIZE * stride * sizeof(float));
+
+    int64_t begin = first < 0 ? 0 : first;
+    int64_t end = first + SPECTROGRAM_FFT_SIZE;
+    if (end > (int64_t)spectrogram->frames) end = (int64_t)spectrogram->frames;
+    if (begin < end) {
+        size_t frames = wav_reader_read(reader, (uint64_t)begin, worker->raw, (size_t)(end - begin));
+        mix_kernels_get()->to_float[reader->format](worker->samples + (begin - first) * stride, worker->raw,
+                                                   frames * stride);
+    }
+
+    worker->loaded_owner = spectrogram;
+    worker->loaded_first = first;
+}
+
+/*
+ * FFT complexa das janelas em re e im (já na ordem de bits invertidos). Como as
+ * duas são reais, o espectro de cada uma sai de Z[k] e Z[N - k]; a potência de
+ * cada faixa entra no máximo da sua linha na coluna de cada janela.
+ */
+static void transform_pair(const SpectrogramEngine* engine, SpectrogramWorker* worker, int column_re, int column_im) {
+    const MixKernels* kernels = mix_kernels_get();
+    for (size_t half = 1; half < SPECTROGRAM_FFT_SIZE; half *= 2) {
+        kernels->fft_stage_f32(worker->re, worker->im, SPECTROGRAM_FFT_SIZE, half,
+                               engine->twiddle_re + half - 1, engine->twiddle_im + half - 1);
+    }
+
+    float* rows_re = worker->rows + (size_t)column_re * SPECTROGRAM_TILE_ROWS;
+    float* rows_im = column_im >= 0 ? worker->rows + (size_t)column_im * SPECTROGRAM_TILE_ROWS : NULL;
+    for (int k = 0; k < SPECTROGRAM_BINS; k++) {
+        int n = (SPECTROGRAM_FFT_SIZE - k) & (SPECTROGRAM_FFT_SIZE - 1);
+        float sum_re = worker->re[k] + worker->re[n];
+        float diff_re = worker->re[k] - worker->re[n];
+        float sum_im = worker->im[k] + worker->im[n];
+        float diff_im = worker->im[k] - worker->im[n];
+        int row = SPECTROGRAM_TILE_ROWS - 1 - k * SPECTROGRAM_TILE_ROWS / SPECTROGRAM_BINS;
+
+        float power = (sum_re * sum_re + diff_im * diff_im) * 0.25f;
+        if (power > rows_re[row]) rows_re[row] = power;
+        if (rows_im) {
+            power = (diff_re * diff_re + sum_im * sum_im) * 0.25f;
+            if (power > rows_im[row]) rows_im[row] = power;
+        }
+    }
+}
+
+/* Põe a janela de um canal em re ou im; a cada duas janelas roda uma FFT. */
+static void add_window(const SpectrogramEngine* engine, SpectrogramWorker* worker, const Spectrogram* spectrogram,
+                       int64_t first, int channel, int column) {
+    load_window(worker, spectrogram, first);
+
+    uint16_t stride = spectrogram->reader.info.num_channels;
+    const float* src = worker->samples + channel;
+    float* target = worker->pending_column < 0 ? worker->re : worker->im;
+    for (int i = 0; i < SPECTROGRAM_FFT_SIZE; i++) {
+        target[engine->reverse[i]] = src[(size_t)i * stride] * engine->window[i];
+    }
+
+    if (worker->pending_column < 0) {
+        worker->pending_column = column;
+        return;
+    }
+    transform_pair(engine, worker, worker->pending_column, column);
+    worker->pending_column = -1;
+}
+
+/*
+ * Potência de cada linha das colunas do ladrilho "index" do nível "level" (até
+ * SPECTROGRAM_FFT_LEVEL) em worker->rows: cada coluna é uma janela centrada
+ * nela, e nos arquivos com mais de um canal vale o mais forte. Devolve quantas
+ * colunas caem dentro do arquivo.
+ */
+static int compute_rows(const SpectrogramEngine* engine, SpectrogramWorker* worker, const Spectrogram* spectrogram,
+                        int level, uint64_t index) {
+    uint64_t column_frames = (uint64_t)1 << level;
+    uint64_t last_column = spectrogram->frames > 0 ? (spectrogram->frames - 1) >> level : 0;
+    int columns = 0;
+
+    memset(worker->rows, 0, sizeof(worker->rows));
+    worker->pending_column = -1;
+
+    for (int column = 0; column < SPECTROGRAM_TILE_COLUMNS; column++) {
+        uint64_t column_index = index * SPECTROGRAM_TILE_COLUMNS + column;
+        if (spectrogram->frames == 0 || column_index > last_column) break;
+        uint64_t first = column_index << level;
+        columns = column + 1;
+
+        int64_t window_first = (int64_t)(first + column_frames / 2) - SPECTROGRAM_FFT_SIZE / 2;
+        for (int channel = 0; channel < spectrogram->channels; channel++) {
+            add_window(engine, worker, spectrogram, window_first, channel, column);
+        }
+    }
+
+    if (worker->pending_column >= 0) {
+        memset(worker->im, 0, sizeof(worker->im));
+        transform_pair(engine, worker, worker->pending_column, -1);
+    }
+    return columns;
+}
+
+/* Índice da paleta para a potência de uma linha, como compute_rows() a deixa. */
+static uint8_t band_intensity(float power) {
+    /* Potência de um seno de amplitude 32768 na sua faixa, com a janela de Hann. */
+    const float reference = 32768.0f * SPECTROGRAM_FFT_SIZE / 4;
+    const float scale = 1.0f / (reference * reference);
+
+    power *= scale;
+    float db = power > 0 ? 10.0f * log10f(power) : SPECTROGRAM_FLOOR_DB;
+    float position = (db - SPECTROGRAM_FLOOR_DB) / -SPECTROGRAM_FLOOR_DB;
+    if (position < 0) position = 0;
+    if (position > 1) position = 1;
+    return (uint8_t)(position * 255);
+}
+
+/*
+ * Garante que os blocos [first_block, last_block] de fft_columns estão
+ * calculados. Blocos que outra thread está calculando ficam para o fim, e só
+ * então a thread espera por eles; assim várias threads dividem o trabalho de
+ * um nível grosso em vez de esperar umas pelas outras.
+ */
+static int ensure_fft_blocks(SpectrogramEngine* engine, SpectrogramWorker* worker, Spectrogram* spectrogram,
+                             uint64_t first_block, uint64_t last_block) {
+    pthread_mutex_lock(&engine->lock);
+    if (!spectrogram->fft_columns) {
+        uint64_t blocks = (spectrogram->fft_column_count + SPECTROGRAM_TILE_COLUMNS - 1) / SPECTROGRAM_TILE_COLUMNS;
+        spectrogram->fft_columns = malloc((size_t)spectrogram->fft_column_count * SPECTROGRAM_TILE_ROWS);
+        spectrogram->fft_blocks = calloc((size_t)blocks, 1);
+        if (!spectrogram->fft_columns || !spectrogram->fft_blocks) {
+            free(spectrogram->fft_columns);
+            free(spectrogram->fft_blocks);
+            spectrogram->fft_columns = NULL;
+            spectrogram->fft_blocks = NULL;
+            pthread_mutex_unlock(&engine->lock);
+            return -1;
+        }
+    }
+
+    for (int pass = 0; pass < 2; pass++) {
+        for (uint64_t block = first_block; block <= last_block; block++) {
+            while (pass == 1 && spectrogram->fft_blocks[block] == FFT_BLOCK_COMPUTING) {
+                pthread_cond_wait(&engine->idle, &engine->lock);
+            }
+            if (spectrogram->fft_blocks[block] != FFT_BLOCK_MISSING) continue;
+
+            spectrogram->fft_blocks[block] = FFT_BLOCK_COMPUTING;
+            pthread_mutex_unlock(&engine->lock);
+
+            int columns = compute_rows(engine, worker, spectrogram, SPECTROGRAM_FFT_LEVEL, block);
+            uint8_t* out = spectrogram->fft_columns + (size_t)block * SPECTROGRAM_TILE_COLUMNS * SPECTROGRAM_TILE_ROWS;
+            for (size_t i = 0; i < (size_t)columns * SPECTROGRAM_TILE_ROWS; i++) {
+                out[i] = band_intensity(worker->rows[i]);
+            }
+
+            pthread_mutex_lock(&engine->lock);
+            spectrogram->fft_blocks[block] = FFT_BLOCK_READY;
+            pthread_cond_broadcast(&engine->idle);
+        }
+    }
+
+    pthread_mutex_unlock(&engine->lock);
+    return 0;
+}
+
+/*
+ * Calcula um ladrilho. Abaixo de SPECTROGRAM_FFT_LEVEL cada coluna é uma FFT
+ * própria. Do SPECTROGRAM_FFT_LEVEL para cima cada coluna é o máximo de cada
+ * linha nas colunas de fft_columns que ela cobre, calculadas uma vez para
+ * todos esses níveis; o máximo faz um clique curto não sumir de longe.
+ * Colunas depois do fim do arquivo ficam transparentes.
+ */
+static int compute_tile(SpectrogramEngine* engine, SpectrogramWorker* worker, Spectrogram* spectrogram,
+                        int level, uint64_t index, uint32_t* pixels) {
+    if (level < SPECTROGRAM_FFT_LEVEL) {
+        int columns = compute_rows(engine, worker, spectrogram, level, index);
+        for (int row = 0; row < SPECTROGRAM_TILE_ROWS; row++) {
+            uint32_t* out = pixels + (size_t)row * SPECTROGRAM_TILE_COLUMNS;
+            for (int column = 0; column < SPECTROGRAM_TILE_COLUMNS; column++) {
+                out[column] = column < columns
+                                  ? engine->palette[band_intensity(worker->rows[(size_t)column * SPECTROGRAM_TILE_ROWS + row])]
+                                  : 0;
+            }
+        }
+        return 0;
+    }
+
+    uint64_t first_column = index * SPECTROGRAM_TILE_COLUMNS;
+    uint64_t last_column = spectrogram->frames > 0 ? (spectrogram->frames - 1) >> level : 0;
+    int columns = 0;
+    if (spectrogram->frames > 0 && first_column <= last_column) {
+        columns = last_column - first_column < SPECTROGRAM_TILE_COLUMNS ? (int)(last_column - first_column + 1)
+                                                                         : SPECTROGRAM_TILE_COLUMNS;
+    }
+
+    int shift = level - SPECTROGRAM_FFT_LEVEL;
+    if (columns > 0) {
+        uint64_t fft_first = first_column << shift;
+        uint64_t fft_last = ((first_column + columns) << shift) - 1;
+        if (fft_last >= spectrogram->fft_column_count) fft_last = spectrogram->fft_column_count - 1;
+        if (ensure_fft_blocks(engine, worker, spectrogram, fft_first / SPECTROGRAM_TILE_COLUMNS,
+                              fft_last / SPECTROGRAM_TILE_COLUMNS) != 0) {
+            return -1;
+        }
+    }
+
+    for (int column = 0; column < SPECTROGRAM_TILE_COLUMNS; column++) {
+        uint8_t intensity[SPECTROGRAM_TILE_ROWS] = { 0 };
+        if (column < columns) {
+            uint64_t fft_first = (first_column + column) << shift;
+            uint64_t fft_end = fft_first + ((uint64_t)1 << shift);
+            if (fft_end > spectrogram->fft_column_count) fft_end = spectrogram->fft_column_count;
+            for (uint64_t fft_column = fft_first; fft_column < fft_end; fft_column++) {
+                const uint8_t* src = spectrogram->fft_columns + (size_t)fft_column * SPECTROGRAM_TILE_ROWS;
+                for (int row = 0; row < SPECTROGRAM_TILE_ROWS; row++) {
+                    if (src[row] > intensity[row]) intensity[row] = src[row];
+                }
+            }
+        }
+        for (int row = 0; row < SPECTROGRAM_TILE_ROWS; row++) {
+            pixels[(size_t)row * SPECTROGRAM_TILE_COLUMNS + column] = column < columns ? engine->palette[intensity[row]] : 0;
+        }
+    }
+    return 0;
+}
+
+/* Tira o ladrilho da pilha de pedidos; o engine precisa estar travado. */
+static void unlink_tile(SpectrogramEngine* engine, SpectrogramTile* tile) {
+    SpectrogramTile** link = &engine->pending;
+    while (*link && *link != tile) link = &(*link)->next;
+    if (*link) *link = tile->next;
+    tile->next = NULL;
+}
+
+static void* spectrogram_worker(void* arg) {
+    SpectrogramEngine* engine = (SpectrogramEngine*)arg;
+    SpectrogramWorker* worker = calloc(1, sizeof(SpectrogramWorker));
+    if (!worker) {
+        printf("Erro ao alocar memória para o espectrograma\n");
+        return NULL;
+    }
+
+    pthread_mutex_lock(&engine->lock);
+    for (;;) {
+        while (!engine->quit && !engine->pending) {
+            pthread_cond_wait(&engine->wake, &engine->lock);
+        }
+        if (engine->quit) break;
+
+        SpectrogramTile* tile = engine->pending;
+        engine->pending = tile->next;
+        tile->next = NULL;
+        tile->state = TILE_COMPUTING;
+        pthread_mutex_unlock(&engine->lock);
+
+        int ok = reserve_buffers(worker, tile->owner) == 0 &&
+                 compute_tile(engine, worker, tile->owner, tile->level, tile->index, tile->pixels) == 0;
+        if (!ok) {
+            printf("Erro ao alocar memória para o espectrograma\n");
+        }
+
+        pthread_mutex_lock(&engine->lock);
+        if (ok) {
+            tile->state = TILE_READY;
+        } else {
+            tile->state = TILE_FREE;
+            tile->owner = NULL;
+        }
+        pthread_cond_broadcast(&engine->idle);
+        pthread_mutex_unlock(&engine->lock);
+
+        if (ok && engine->progress) {
+            engine->progress(engine->user);
+        }
+        pthread_mutex_lock(&engine->lock);
+    }
+    pthread_mutex_unlock(&engine->lock);
+
+    free(worker->raw);
+    free(worker->samples);
+    free(worker);
+    return NULL;
+}
+
+/*
+ * Cria uma thread por núcleo. progress é chamada de uma dessas threads a cada
+ * ladrilho pronto; quem usa o GTK deve só agendar o redesenho a partir dela.
+ */
+SpectrogramEngine* spectrogram_engine_create(void (*progress)(void* user), void* user) {
+    SpectrogramEngine* engine = calloc(1, sizeof(SpectrogramEngine));
+    if (!engine) return NULL;
+
+    pthread_mutex_init(&engine->lock, NULL);
+    pthread_cond_init(&engine->wake, NULL);
+    pthread_cond_init(&engine->idle, NULL);
+    engine->progress = progress;
+    engine->user = user;
+    init_tables(engine);
+
+    int thread_count = spectrogram_thread_count();
+    engine->threads = malloc(thread_count * sizeof(pthread_t));
+    if (engine->threads) {
+        for (; engine->thread_count < thread_count; engine->thread_count++) {
+            if (pthread_create(&engine->threads[engine->thread_count], NULL, spectrogram_worker, engine) != 0) break;
+        }
+    }
+    if (engine->thread_count == 0) {
+        printf("Erro ao criar as threads do espectrograma\n");
+        spectrogram_engine_destroy(engine);
+        return NULL;
+    }
+
+    return engine;
+}
+
+/*
+ * Abre o arquivo para o espectrograma, que passa a ser do engine. Nada é
+ * calculado até os ladrilhos serem pedidos. Só os dois primeiros canais
+ * entram (L e R num multicanal).
+ */
+Spectrogram* spectrogram_engine_add(SpectrogramEngine* engine, const char* filename) {
+    Spectrogram* spectrogram = calloc(1, sizeof(Spectrogram));
+    if (!spectrogram) return NULL;
+    if (wav_reader_open(&spectrogram->reader, filename, WAV_READER_MAP) != 0) {
+        free(spectrogram);
+        return NULL;
+    }
+    if (spectrogram->reader.format == WAV_SAMPLE_UNSUPPORTED || spectrogram->reader.info.num_channels == 0) {
+        printf("Formato não suportado para o espectrograma: %s\n", filename);
+        wav_reader_close(&spectrogram->reader);
+        free(spectrogram);
+        return NULL;
+    }
+
+    spectrogram->frames = spectrogram->reader.info.duration_samples;
+    spectrogram->sample_rate = spectrogram->reader.info.sample_rate;
+    spectrogram->channels = spectrogram->reader.info.num_channels < 2 ? spectrogram->reader.info.num_channels : 2;
+    spectrogram->fft_column_count = (spectrogram->frames + SPECTROGRAM_FFT_SIZE - 1) / SPECTROGRAM_FFT_SIZE;
+
+    pthread_mutex_lock(&engine->lock);
+    spectrogram->next = engine->spectrograms;
+    engine->spectrograms = spectrogram;
+    pthread_mutex_unlock(&engine->lock);
+    return spectrogram;
+}
+
+/* Descarta os ladrilhos do espectrograma (esperando os que estão sendo calculados) e o libera. */
+void spectrogram_engine_remove(SpectrogramEngine* engine, Spectrogram* spectrogram) {
+    pthread_mutex_lock(&engine->lock);
+    for (;;) {
+        int busy = 0;
+        for (int i = 0; i < SPECTROGRAM_CACHE_TILES; i++) {
+            SpectrogramTile* tile = &engine->tiles[i];
+            if (tile->owner != spectrogram) continue;
+            if (tile->state == TILE_COMPUTING) {
+                busy = 1;
+                continue;
+            }
+            if (tile->state == TILE_QUEUED) unlink_tile(engine, tile);
+            tile->state = TILE_FREE;
+            tile->owner = NULL;
+        }
+        if (!busy) break;
+        pthread_cond_wait(&engine->idle, &engine->lock);
+    }
+    for (Spectrogram** link = &engine->spectrograms; *link; link = &(*link)->next) {
+        if (*link == spectrogram) {
+            *link = spectrogram->next;
+            break;
+        }
+    }
+    pthread_mutex_unlock(&engine->lock);
+
+    wav_reader_close(&spectrogram->reader);
+    free(spectrogram->fft_columns);
+    free(spectrogram->fft_blocks);
+    free(spectrogram);
+}
+
+/*
+ * Pixels do ladrilho "index" do nível "level" (colunas a partir de
+ * index * SPECTROGRAM_TILE_COLUMNS), ou NULL se ainda não está pronto: nesse
+ * caso ele é pedido às threads e progress avisa quando terminar. Só a thread
+ * do GTK chama esta função; os pixels valem até a próxima chamada, que pode
+ * reaproveitar a vaga do ladrilho usado há mais tempo.
+ */
+const uint32_t* spectrogram_tile(SpectrogramEngine* engine, Spectrogram* spectrogram, int level, uint64_t index) {
+    pthread_mutex_lock(&engine->lock);
+    engine->clock++;
+
+    SpectrogramTile* victim = NULL;
+    for (int i = 0; i < SPECTROGRAM_CACHE_TILES; i++) {
+        SpectrogramTile* tile = &engine->tiles[i];
+        if (tile->owner == spectrogram && tile->level == level && tile->index == index) {
+            tile->last_used = engine->clock;
+            const uint32_t* pixels = tile->state == TILE_READY ? tile->pixels : NULL;
+            pthread_mutex_unlock(&engine->lock);
+            return pixels;
+        }
+        if (tile->state == TILE_COMPUTING) continue;
+        if (!victim || (victim->state != TILE_FREE &&
+                        (tile->state == TILE_FREE || tile->last_used < victim->last_used))) {
+            victim = tile;
+        }
+    }
+
+    if (victim && !victim->pixels) {
+        victim->pixels = malloc((size_t)SPECTROGRAM_TILE_COLUMNS * SPECTROGRAM_TILE_ROWS * sizeof(uint32_t));
+    }
+    if (victim && victim->pixels) {
+        if (victim->state == TILE_QUEUED) unlink_tile(engine, victim);
+        victim->owner = spectrogram;
+        victim->level = level;
+        victim->index = index;
+        victim->state = TILE_QUEUED;
+        victim->last_used = engine->clock;
+        victim->next = engine->pending;
+        engine->pending = victim;
+        pthread_cond_signal(&engine->wake);
+    }
+
+    pthread_mutex_unlock(&engine->lock);
+    return NULL;
+}
+
+/* Para as threads e libera os ladrilhos e os espectrogramas que ainda não foram removidos. */
+void spectrogram_engine_destroy(SpectrogramEngine* engine) {
+    if (!engine) return;
+
+    pthread_mutex_lock(&engine->lock);
+    engine->quit = 1;
+    pthread_cond_broadcast(&engine->wake);
+    pthread_mutex_unlock(&engine->lock);
+
+    for (int i = 0; i < engine->thread_count; i++) {
+        pthread_join(engine->threads[i], NULL);
+    }
+
+    for (int i = 0; i < SPECTROGRAM_CACHE_TILES; i++) {
+        free(engine->tiles[i].pixels);
+    }
+    while (engine->spectrograms) {
+        Spectrogram* spectrogram = engine->spectrograms;
+        engine->spectrograms = spectrogram->next;
+        wav_reader_close(&spectrogram->reader);
+        free(spectrogram->fft_columns);
+        free(spectrogram->fft_blocks);
+        free(spectrogram);
+    }
+    pthread_cond_destroy(&engine->idle);
+    pthread_cond_destroy(&engine->wake);
+    pthread_mutex_destroy(&engine->lock);
+    free(engine->threads);
+    free(engine);
+}
@@ -0,0 +1,63 @@
+#ifndef SPECTROGRAM_H
+#define SPECTROGRAM_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "wav_reader.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Tamanho da FFT (potência de 2) e dos ladrilhos: cada ladrilho tem
+ * SPECTROGRAM_TILE_COLUMNS colunas de SPECTROGRAM_TILE_ROWS linhas, a linha 0
+ * na frequência mais alta. No nível k cada coluna resume 1 << k quadros.
+ */
+#define SPECTROGRAM_FFT_SIZE 2048
+#define SPECTROGRAM_TILE_COLUMNS 256
+#define SPECTROGRAM_TILE_ROWS 128
+#define SPECTROGRAM_MIN_LEVEL 4
+#define SPECTROGRAM_MAX_LEVEL 40
+
+/* Ladrilhos guardados (de todos os clipes); os usados há mais tempo dão lugar aos novos. */
+#define SPECTROGRAM_CACHE_TILES 256
+
+/*
+ * Espectrograma de um arquivo: o arquivo mapeado, lido pelas threads do
+ * SpectrogramEngine, e os dados para achar o ladrilho de um trecho. Pertence
+ * ao engine que o criou, que guarda todos numa lista (next).
+ *
+ * fft_columns guarda a intensidade (índice da paleta) de cada linha nas
+ * colunas de SPECTROGRAM_FFT_SIZE quadros, uma FFT por coluna; os níveis mais
+ * grossos saem do máximo delas, sem outra FFT. É alocado e calculado aos
+ * poucos, em blocos de SPECTROGRAM_TILE_COLUMNS colunas (fft_blocks diz o
+ * estado de cada um).
+ */
+typedef struct Spectrogram {
+    WavReader reader;
+    uint64_t frames;
+    uint32_t sample_rate;
+    int channels;
+    uint8_t* fft_columns;
+    uint8_t* fft_blocks;
+    uint64_t fft_column_count;
+    struct Spectrogram* next;
+} Spectrogram;
+
+/* Threads que calculam os ladrilhos e o cache deles, ver spectrogram_tile(). */
+typedef struct SpectrogramEngine SpectrogramEngine;
+
+int spectrogram_level(double frames_per_pixel);
+
+SpectrogramEngine* spectrogram_engine_create(void (*progress)(void* user), void* user);
+Spectrogram* spectrogram_engine_add(SpectrogramEngine* engine, const char* filename);
+void spectrogram_engine_remove(SpectrogramEngine* engine, Spectrogram* spectrogram);
+const uint32_t* spectrogram_tile(SpectrogramEngine* engine, Spectrogram* spectrogram, int level, uint64_t index);
+void spectrogram_engine_destroy(SpectrogramEngine* engine);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -4,14 +4,21 @@
 #include <stdint.h>
 #include <math.h>
 #include <errno.h>
+#include <pthread.h>
 #ifdef _WIN32
+#include <windows.h>
 #include <io.h>
 #define access _access
 #define F_OK 0
 #else
 #include <unistd.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 #endif
 #include "wav_reader.h"
+#include "mix_kernels.h"
+#include "resampler.h"
 
 #pragma pack(push, 1)
 typedef struct {
@@ -31,324 +38,1414 @@ typedef struct {
     uint16_t bitsPerSample;
 } WAV_Fmt;
 
+typedef struct {
+    uint16_t cbSize;
+    uint16_t validBitsPerSample;
+    uint32_t channelMask;
+    uint8_t subFormat[16];
+} WAV_FmtExtensible;
+
 typedef struct {
     char subchunk2ID[4];
     uint32_t subchunk2Size;
 } WAV_Data;
+
+/* Chunk "ds64" do RF64: tamanhos de 64 bits que não cabem nos campos de 32. */
+typedef struct {
+    char chunkID[4];
+    uint32_t chunkSize;
+    uint64_t riffSize;
+    uint64_t dataSize;
+    uint64_t sampleCount;
+    uint32_t tableLength;
+} WAV_DS64;
 #pragma pack(pop)
 
-int mix_wav_files(const char* output_file, const char* input_files[], float volumes[], float pans[], int file_count) {
-    if (file_count == 0) {
-        printf("Erro: Nenhum arquivo para mixar\n");
+#define RIFF_SIZE_LIMIT 0xFFFFFFFFu
+
+/* GUID do subformato sem os dois primeiros bytes, que são o código do formato (1 = PCM, 3 = float). */
+static const uint8_t wav_subformat_tail[14] = {
+    0x00, 0x00, 0x00, 0x00, 0x10, 0x00, 0x80, 0x00, 0x00, 0xAA, 0x00, 0x38, 0x9B, 0x71
+};
+
+/* Leitura e escrita posicionais: várias threads usam o mesmo arquivo sem disputar o cursor. */
+static size_t read_at(FILE* file, void* buffer, size_t size, int64_t offset) {
+#ifdef _WIN32
+    HANDLE handle = (HANDLE)_get_osfhandle(_fileno(file));
+    OVERLAPPED overlapped = {0};
+    overlapped.Offset = (DWORD)offset;
+    overlapped.OffsetHigh = (DWORD)(offset >> 32);
+    DWORD bytes_read = 0;
+    if (!ReadFile(handle, buffer, (DWORD)size, &bytes_read, &overlapped)) return 0;
+    return bytes_read;
+#else
+    size_t total = 0;
+    while (total < size) {
+        ssize_t n = pread(fileno(file), (char*)buffer + total, size - total, offset + total);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) break;
+        total += n;
+    }
+    return total;
+#endif
+}
+
+static size_t write_at(FILE* file, const void* buffer, size_t size, int64_t offset) {
+#ifdef _WIN32
+    HANDLE handle = (HANDLE)_get_osfhandle(_fileno(file));
+    OVERLAPPED overlapped = {0};
+    overlapped.Offset = (DWORD)offset;
+    overlapped.OffsetHigh = (DWORD)(offset >> 32);
+    DWORD bytes_written = 0;
+    if (!WriteFile(handle, buffer, (DWORD)size, &bytes_written, &overlapped)) return 0;
+    return bytes_written;
+#else
+    size_t total = 0;
+    while (total < size) {
+        ssize_t n = pwrite(fileno(file), (const char*)buffer + total, size - total, offset + total);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) break;
+        total += n;
+    }
+    return total;
+#endif
+}
+
+static int64_t file_length(FILE* file) {
+#ifdef _WIN32
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx((HANDLE)_get_osfhandle(_fileno(file)), &size)) return -1;
+    return (int64_t)size.QuadPart;
+#else
+    struct stat st;
+    if (fstat(fileno(file), &st) != 0) return -1;
+    return st.st_size;
+#endif
+}
+
+/*
+ * Percorre os chunks RIFF uma única vez, guardando o formato e onde começa o chunk "data".
+ * Em RF64 (e BW64) o tamanho real do "data" vem do chunk "ds64".
+ */
+static int parse_wav_header(FILE* file, WAV_Info* info, int64_t* data_offset) {
+    WAV_Header header;
+    if (read_at(file, &header, sizeof(WAV_Header), 0) != sizeof(WAV_Header) ||
+        strncmp(header.format, "WAVE", 4) != 0) {
         return -1;
     }
-    
 
-    FILE** files = malloc(file_count * sizeof(FILE*));
-    WAV_Header* headers = malloc(file_count * sizeof(WAV_Header));
-    WAV_Fmt* fmts = malloc(file_count * sizeof(WAV_Fmt));
-    WAV_Data* datas = malloc(file_count * sizeof(WAV_Data));
-    char** actual_paths = malloc(file_count * sizeof(char*));
-    
-    uint32_t max_data_size = 0;
-    uint32_t sample_rate = 44100;
-    uint16_t num_channels = 2;
-    uint16_t bits_per_sample = 16;
+    int rf64 = strncmp(header.chunkID, "RF64", 4) == 0 || strncmp(header.chunkID, "BW64", 4) == 0;
+    if (!rf64 && strncmp(header.chunkID, "RIFF", 4) != 0) {
+        return -1;
+    }
 
-    for (int i = 0; i < file_count; i++) {
-        const char *filename = input_files[i];
-        char *actual_path = NULL;
-        
-        if (access(filename, F_OK) != 0) {
-            const char *basename = strrchr(filename, '/');
-            if (!basename) basename = strrchr(filename, '\\');
-            if (basename) basename++;
-            else basename = filename;
-            
-            const char *alternatives[] = {
-                "../audio/",
-                "audio/",
-                "./audio/",
-                NULL
-            };
-            
-            int found = 0;
-            for (int alt = 0; alternatives[alt] != NULL; alt++) {
-                size_t len = strlen(alternatives[alt]) + strlen(basename) + 1;
-                actual_path = malloc(len);
-                snprintf(actual_path, len, "%s%s", alternatives[alt], basename);
-                
-                if (access(actual_path, F_OK) == 0) {
-                    found = 1;
-                    break;
-                }
-                free(actual_path);
-                actual_path = NULL;
+    int64_t length = file_length(file);
+    int have_fmt = 0;
+    uint64_t ds64_data_size = 0;
+    int64_t offset = sizeof(WAV_Header);
+    char chunk[8];
+    *data_offset = 0;
+
+    while (read_at(file, chunk, sizeof(chunk), offset) == sizeof(chunk)) {
+        uint32_t chunk_size;
+        memcpy(&chunk_size, chunk + 4, 4);
+
+        if (rf64 && strncmp(chunk, "ds64", 4) == 0) {
+            WAV_DS64 ds64;
+            if (read_at(file, &ds64, sizeof(WAV_DS64), offset) != sizeof(WAV_DS64)) return -1;
+            ds64_data_size = ds64.dataSize;
+        } else if (strncmp(chunk, "fmt ", 4) == 0) {
+            WAV_Fmt fmt;
+            if (read_at(file, &fmt, sizeof(WAV_Fmt), offset) != sizeof(WAV_Fmt)) return -1;
+            info->sample_rate = fmt.sampleRate;
+            info->num_channels = fmt.numChannels;
+            info->bits_per_sample = fmt.bitsPerSample;
+            info->audio_format = fmt.audioFormat;
+            info->channel_mask = 0;
+
+            if (fmt.audioFormat == WAV_FORMAT_EXTENSIBLE && chunk_size >= sizeof(WAV_Fmt) - 8 + sizeof(WAV_FmtExtensible)) {
+                WAV_FmtExtensible ext;
+                if (read_at(file, &ext, sizeof(ext), offset + sizeof(WAV_Fmt)) != sizeof(ext)) return -1;
+                memcpy(&info->audio_format, ext.subFormat, 2);
+                info->channel_mask = ext.channelMask;
             }
-            
-            if (!found) {
-                printf("Erro ao abrir: %s\n", input_files[i]);
-                for (int j = 0; j < i; j++) {
-                    fclose(files[j]);
-                    if (actual_paths[j] != input_files[j]) free(actual_paths[j]);
-                }
-                free(files); free(headers); free(fmts); free(datas); free(actual_paths);
-                return -1;
+            have_fmt = 1;
+        } else if (strncmp(chunk, "data", 4) == 0) {
+            *data_offset = offset + sizeof(chunk);
+            info->data_size = (rf64 && chunk_size == RIFF_SIZE_LIMIT) ? ds64_data_size : chunk_size;
+            if (length >= *data_offset && (uint64_t)(length - *data_offset) < info->data_size) {
+                info->data_size = (uint64_t)(length - *data_offset);
             }
-        } else {
-            actual_path = (char *)filename;
+            break;
         }
-        
-        files[i] = fopen(actual_path, "rb");
-        if (!files[i]) {
-            printf("Erro ao abrir: %s\n", actual_path);
-            if (actual_path != filename) free(actual_path);
-            for (int j = 0; j < i; j++) {
-                fclose(files[j]);
-                if (actual_paths[j] != input_files[j]) free(actual_paths[j]);
+
+        offset += sizeof(chunk) + chunk_size + (chunk_size & 1);
+    }
+
+    if (!have_fmt || *data_offset == 0 || info->num_channels == 0 || info->bits_per_sample < 8) {
+        return -1;
+    }
+
+    info->duration_samples = info->data_size / (info->num_channels * (info->bits_per_sample / 8));
+    return 0;
+}
+
+WavSampleFormat wav_sample_format(const WAV_Info* info) {
+    if (!info) return WAV_SAMPLE_UNSUPPORTED;
+
+    if (info->audio_format == WAV_FORMAT_PCM) {
+        switch (info->bits_per_sample) {
+        case 8: return WAV_SAMPLE_U8;
+        case 16: return WAV_SAMPLE_S16;
+        case 24: return WAV_SAMPLE_S24;
+        case 32: return WAV_SAMPLE_S32;
+        default: return WAV_SAMPLE_UNSUPPORTED;
+        }
+    }
+    if (info->audio_format == WAV_FORMAT_IEEE_FLOAT && info->bits_per_sample == 32) {
+        return WAV_SAMPLE_F32;
+    }
+    return WAV_SAMPLE_UNSUPPORTED;
+}
+
+uint16_t wav_sample_bytes(WavSampleFormat format) {
+    static const uint16_t bytes[WAV_SAMPLE_FORMAT_COUNT] = { 0, 1, 2, 3, 4, 4 };
+    return (format >= 0 && format < WAV_SAMPLE_FORMAT_COUNT) ? bytes[format] : 0;
+}
+
+static int map_reader_data(WavReader* reader) {
+#ifdef _WIN32
+    HANDLE mapping = CreateFileMappingA((HANDLE)_get_osfhandle(_fileno(reader->file)),
+                                        NULL, PAGE_READONLY, 0, 0, NULL);
+    if (!mapping) return -1;
+
+    void* base = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    if (!base) {
+        CloseHandle(mapping);
+        return -1;
+    }
+    reader->map_handle = mapping;
+#else
+    void* base = mmap(NULL, reader->map_length, PROT_READ, MAP_SHARED, fileno(reader->file), 0);
+    if (base == MAP_FAILED) return -1;
+#endif
+    reader->map_base = base;
+    reader->data = (const uint8_t*)base + reader->data_offset;
+    return 0;
+}
+
+int wav_reader_open(WavReader* reader, const char* filename, int flags) {
+    if (!reader || !filename) return -1;
+    memset(reader, 0, sizeof(WavReader));
+
+    reader->file = fopen(filename, "rb");
+    if (!reader->file) return -1;
+
+    if (parse_wav_header(reader->file, &reader->info, &reader->data_offset) != 0) {
+        wav_reader_close(reader);
+        return -1;
+    }
+    reader->block_align = reader->info.num_channels * (reader->info.bits_per_sample / 8);
+    reader->format = wav_sample_format(&reader->info);
+
+    /* O mapeamento é opcional: se falhar, as leituras posicionais continuam valendo. */
+    /* Em sistemas de 32 bits um arquivo maior que o espaço de endereços fica sem mapeamento. */
+    uint64_t map_length = (uint64_t)reader->data_offset + reader->info.data_size;
+    if ((flags & WAV_READER_MAP) && reader->info.data_size > 0 && (reader->data_offset & 1) == 0 &&
+        map_length <= (uint64_t)(SIZE_MAX / 2)) {
+        reader->map_length = (size_t)map_length;
+        if (map_reader_data(reader) != 0) {
+            reader->map_length = 0;
+        }
+    }
+
+    return 0;
+}
+
+size_t wav_reader_read(const WavReader* reader, uint64_t first_frame, void* buffer, size_t frames) {
+    if (!reader || !reader->file || first_frame >= reader->info.duration_samples) return 0;
+
+    if (frames > reader->info.duration_samples - first_frame) {
+        frames = reader->info.duration_samples - first_frame;
+    }
+
+    size_t bytes = frames * reader->block_align;
+    int64_t offset = reader->data_offset + (int64_t)first_frame * reader->block_align;
+
+    if (reader->data) {
+        memcpy(buffer, reader->data + (offset - reader->data_offset), bytes);
+        return frames;
+    }
+
+    return read_at(reader->file, buffer, bytes, offset) / reader->block_align;
+}
+
+/* Uma amostra convertida para a escala de 16 bits do barramento; 0 fora do arquivo. */
+float wav_reader_sample(const WavReader* reader, size_t frame, uint16_t channel) {
+    if (!reader || reader->format == WAV_SAMPLE_UNSUPPORTED ||
+        frame >= reader->info.duration_samples || channel >= reader->info.num_channels) {
+        return 0.0f;
+    }
+
+    uint16_t sample_bytes = wav_sample_bytes(reader->format);
+    size_t position = frame * reader->block_align + (size_t)channel * sample_bytes;
+    uint8_t raw[4];
+    const uint8_t* bytes = raw;
+    if (reader->data) {
+        bytes = reader->data + position;
+    } else if (read_at(reader->file, raw, sample_bytes, reader->data_offset + (int64_t)position) != sample_bytes) {
+        return 0.0f;
+    }
+
+    float value;
+    mix_kernels_get()->to_float[reader->format](&value, bytes, 1);
+    return value;
+}
+
+void wav_reader_close(WavReader* reader) {
+    if (!reader) return;
+
+    if (reader->map_base) {
+#ifdef _WIN32
+        UnmapViewOfFile(reader->map_base);
+        CloseHandle((HANDLE)reader->map_handle);
+#else
+        munmap(reader->map_base, reader->map_length);
+#endif
+    }
+    if (reader->file) fclose(reader->file);
+    memset(reader, 0, sizeof(WavReader));
+}
+
+#define SPEAKER_LEFT_SIDE (WAV_SPEAKER_FRONT_LEFT | WAV_SPEAKER_FRONT_LEFT_OF_CENTER | \
+                           WAV_SPEAKER_BACK_LEFT | WAV_SPEAKER_SIDE_LEFT)
+#define SPEAKER_RIGHT_SIDE (WAV_SPEAKER_FRONT_RIGHT | WAV_SPEAKER_FRONT_RIGHT_OF_CENTER | \
+                            WAV_SPEAKER_BACK_RIGHT | WAV_SPEAKER_SIDE_RIGHT)
+#define LAYOUT_MASK_5_1 (WAV_SPEAKER_FRONT_LEFT | WAV_SPEAKER_FRONT_RIGHT | WAV_SPEAKER_FRONT_CENTER | \
+                         WAV_SPEAKER_LOW_FREQUENCY | WAV_SPEAKER_BACK_LEFT | WAV_SPEAKER_BACK_RIGHT)
+#define LAYOUT_MASK_7_1 (LAYOUT_MASK_5_1 | WAV_SPEAKER_SIDE_LEFT | WAV_SPEAKER_SIDE_RIGHT)
+
+uint16_t mix_layout_channels(MixChannelLayout layout) {
+    switch (layout) {
+    case MIX_LAYOUT_STEREO: return 2;
+    case MIX_LAYOUT_MONO: return 1;
+    case MIX_LAYOUT_5_1: return 6;
+    case MIX_LAYOUT_7_1: return 8;
+    case MIX_LAYOUT_FOA: return 4;
+    default: return 0;
+    }
+}
+
+uint32_t mix_layout_mask(MixChannelLayout layout) {
+    switch (layout) {
+    case MIX_LAYOUT_STEREO: return WAV_SPEAKER_FRONT_LEFT | WAV_SPEAKER_FRONT_RIGHT;
+    case MIX_LAYOUT_MONO: return WAV_SPEAKER_FRONT_CENTER;
+    case MIX_LAYOUT_5_1: return LAYOUT_MASK_5_1;
+    case MIX_LAYOUT_7_1: return LAYOUT_MASK_7_1;
+    default: return 0;
+    }
+}
+
+/* Layout padrão quando o arquivo não traz dwChannelMask. */
+static uint32_t default_channel_mask(uint16_t channels) {
+    switch (channels) {
+    case 1: return WAV_SPEAKER_FRONT_CENTER;
+    case 2: return WAV_SPEAKER_FRONT_LEFT | WAV_SPEAKER_FRONT_RIGHT;
+    case 3: return WAV_SPEAKER_FRONT_LEFT | WAV_SPEAKER_FRONT_RIGHT | WAV_SPEAKER_FRONT_CENTER;
+    case 4: return WAV_SPEAKER_FRONT_LEFT | WAV_SPEAKER_FRONT_RIGHT | WAV_SPEAKER_BACK_LEFT | WAV_SPEAKER_BACK_RIGHT;
+    case 6: return LAYOUT_MASK_5_1;
+    case 8: return LAYOUT_MASK_7_1;
+    default: return 0;
+    }
+}
+
+/* Alto-falante do canal "index": o index-ésimo bit ligado da máscara, ou 0 se sobrar canal. */
+static uint32_t channel_speaker(uint32_t mask, uint16_t index) {
+    for (int bit = 0; bit < 32; bit++) {
+        if (mask & (1u << bit)) {
+            if (index == 0) return 1u << bit;
+            index--;
+        }
+    }
+    return 0;
+}
+
+static int speaker_index(uint32_t mask, uint32_t speaker) {
+    int index = 0;
+    for (uint32_t below = mask & (speaker - 1); below; below &= below - 1) index++;
+    return index;
+}
+
+/* Direção de cada alto-falante no plano horizontal, positiva para a esquerda. */
+static float speaker_azimuth(uint32_t speaker) {
+    switch (speaker) {
+    case WAV_SPEAKER_FRONT_LEFT: return 30.0f * (float)M_PI / 180.0f;
+    case WAV_SPEAKER_FRONT_RIGHT: return -30.0f * (float)M_PI / 180.0f;
+    case WAV_SPEAKER_FRONT_LEFT_OF_CENTER: return 15.0f * (float)M_PI / 180.0f;
+    case WAV_SPEAKER_FRONT_RIGHT_OF_CENTER: return -15.0f * (float)M_PI / 180.0f;
+    case WAV_SPEAKER_BACK_LEFT: return 110.0f * (float)M_PI / 180.0f;
+    case WAV_SPEAKER_BACK_RIGHT: return -110.0f * (float)M_PI / 180.0f;
+    case WAV_SPEAKER_SIDE_LEFT: return 90.0f * (float)M_PI / 180.0f;
+    case WAV_SPEAKER_SIDE_RIGHT: return -90.0f * (float)M_PI / 180.0f;
+    case WAV_SPEAKER_BACK_CENTER: return (float)M_PI;
+    default: return 0.0f;
+    }
+}
+
+typedef struct {
+    uint32_t speaker;
+    uint32_t targets;
+    float gain;
+} SpeakerRoute;
+
+/*
+ * Para onde vai um alto-falante que a saída não tem: vale a primeira rota
+ * cujos destinos existem todos. LFE e os canais de altura ficam de fora,
+ * como no downmix ITU-R BS.775.
+ */
+static const SpeakerRoute speaker_routes[] = {
+    { WAV_SPEAKER_FRONT_LEFT_OF_CENTER, WAV_SPEAKER_FRONT_LEFT, 1.0f },
+    { WAV_SPEAKER_FRONT_RIGHT_OF_CENTER, WAV_SPEAKER_FRONT_RIGHT, 1.0f },
+    { WAV_SPEAKER_BACK_LEFT, WAV_SPEAKER_SIDE_LEFT, 1.0f },
+    { WAV_SPEAKER_BACK_RIGHT, WAV_SPEAKER_SIDE_RIGHT, 1.0f },
+    { WAV_SPEAKER_SIDE_LEFT, WAV_SPEAKER_BACK_LEFT, 1.0f },
+    { WAV_SPEAKER_SIDE_RIGHT, WAV_SPEAKER_BACK_RIGHT, 1.0f },
+    { WAV_SPEAKER_FRONT_CENTER, WAV_SPEAKER_FRONT_LEFT | WAV_SPEAKER_FRONT_RIGHT, 0.70710678f },
+    { WAV_SPEAKER_BACK_CENTER, WAV_SPEAKER_BACK_LEFT | WAV_SPEAKER_BACK_RIGHT, 0.70710678f },
+    { WAV_SPEAKER_BACK_CENTER, WAV_SPEAKER_SIDE_LEFT | WAV_SPEAKER_SIDE_RIGHT, 0.70710678f },
+    { WAV_SPEAKER_BACK_CENTER, WAV_SPEAKER_FRONT_LEFT | WAV_SPEAKER_FRONT_RIGHT, 0.5f },
+    { WAV_SPEAKER_BACK_LEFT, WAV_SPEAKER_FRONT_LEFT, 0.70710678f },
+    { WAV_SPEAKER_BACK_RIGHT, WAV_SPEAKER_FRONT_RIGHT, 0.70710678f },
+    { WAV_SPEAKER_SIDE_LEFT, WAV_SPEAKER_FRONT_LEFT, 0.70710678f },
+    { WAV_SPEAKER_SIDE_RIGHT, WAV_SPEAKER_FRONT_RIGHT, 0.70710678f },
+    { WAV_SPEAKER_FRONT_LEFT, WAV_SPEAKER_FRONT_CENTER, 0.5f },
+    { WAV_SPEAKER_FRONT_RIGHT, WAV_SPEAKER_FRONT_CENTER, 0.5f },
+    { WAV_SPEAKER_FRONT_LEFT_OF_CENTER, WAV_SPEAKER_FRONT_CENTER, 0.5f },
+    { WAV_SPEAKER_FRONT_RIGHT_OF_CENTER, WAV_SPEAKER_FRONT_CENTER, 0.5f },
+    { WAV_SPEAKER_BACK_LEFT, WAV_SPEAKER_FRONT_CENTER, 0.35355339f },
+    { WAV_SPEAKER_BACK_RIGHT, WAV_SPEAKER_FRONT_CENTER, 0.35355339f },
+    { WAV_SPEAKER_SIDE_LEFT, WAV_SPEAKER_FRONT_CENTER, 0.35355339f },
+    { WAV_SPEAKER_SIDE_RIGHT, WAV_SPEAKER_FRONT_CENTER, 0.35355339f },
+    { WAV_SPEAKER_BACK_CENTER, WAV_SPEAKER_FRONT_CENTER, 0.70710678f }
+};
+
+static void route_speaker(uint32_t speaker, uint32_t out_mask, float* column) {
+    if (out_mask & speaker) {
+        column[speaker_index(out_mask, speaker)] += 1.0f;
+        return;
+    }
+
+    for (size_t r = 0; r < sizeof(speaker_routes) / sizeof(speaker_routes[0]); r++) {
+        const SpeakerRoute* route = &speaker_routes[r];
+        if (route->speaker != speaker || (route->targets & out_mask) != route->targets) continue;
+
+        for (int bit = 0; bit < 32; bit++) {
+            if (route->targets & (1u << bit)) {
+                column[speaker_index(out_mask, 1u << bit)] += route->gain;
             }
-            free(files); free(headers); free(fmts); free(datas); free(actual_paths);
-            return -1;
         }
-        
-        if (actual_path != filename) {
-            actual_paths[i] = actual_path;
-        } else {
-            actual_paths[i] = (char *)filename;
+        return;
+    }
+}
+
+/*
+ * Preenche a matriz (colunas de mix_layout_channels(layout) floats, uma por
+ * canal de entrada) que leva o arquivo para o layout da saída, com volume e
+ * pan já aplicados. Canais sem alto-falante conhecido vão para o canal de
+ * mesmo índice. Devolve o número de canais da saída, ou -1.
+ */
+int mix_channel_matrix(const WAV_Info* info, MixChannelLayout layout, float volume, float pan, float* matrix) {
+    uint16_t out_channels = mix_layout_channels(layout);
+    if (!info || !matrix || out_channels == 0 || info->num_channels == 0) return -1;
+
+    uint16_t in_channels = info->num_channels;
+    uint32_t out_mask = mix_layout_mask(layout);
+    uint32_t in_mask = info->channel_mask ? info->channel_mask : default_channel_mask(in_channels);
+    memset(matrix, 0, (size_t)in_channels * out_channels * sizeof(float));
+
+    if (layout == MIX_LAYOUT_FOA) {
+        /* Cada alto-falante vira uma onda plana na sua direção; o pan gira o campo todo. */
+        float rotation = -pan * (float)M_PI / 2.0f;
+        float c = cosf(rotation);
+        float s = sinf(rotation);
+        for (uint16_t ch = 0; ch < in_channels; ch++) {
+            float* column = matrix + (size_t)ch * out_channels;
+
+            /* 4 canais sem máscara já são FOA: só gira Y/X e aplica o volume. */
+            if (in_channels == 4 && info->channel_mask == 0) {
+                column[ch] = volume;
+                if (ch == 1) {
+                    column[1] = volume * c;
+                    column[3] = -volume * s;
+                } else if (ch == 3) {
+                    column[1] = volume * s;
+                    column[3] = volume * c;
+                }
+                continue;
+            }
+
+            uint32_t speaker = (in_channels == 1) ? WAV_SPEAKER_FRONT_CENTER : channel_speaker(in_mask, ch);
+            if (speaker == 0 || speaker == WAV_SPEAKER_LOW_FREQUENCY) continue;
+
+            float azimuth = speaker_azimuth(speaker) + rotation;
+            column[0] = volume;
+            column[1] = volume * sinf(azimuth);
+            column[3] = volume * cosf(azimuth);
         }
+        return out_channels;
+    }
 
-        fread(&headers[i], sizeof(WAV_Header), 1, files[i]);
-        fread(&fmts[i], sizeof(WAV_Fmt), 1, files[i]);
-        
-        char chunk_id[4];
-        uint32_t chunk_size;
-        while (fread(chunk_id, 4, 1, files[i]) == 1) {
-            if (strncmp(chunk_id, "data", 4) == 0) {
-                fread(&chunk_size, 4, 1, files[i]);
-                datas[i].subchunk2ID[0] = 'd';
-                datas[i].subchunk2ID[1] = 'a';
-                datas[i].subchunk2ID[2] = 't';
-                datas[i].subchunk2ID[3] = 'a';
-                datas[i].subchunk2Size = chunk_size;
-                break;
+    for (uint16_t ch = 0; ch < in_channels; ch++) {
+        float* column = matrix + (size_t)ch * out_channels;
+
+        /* Mono é uma fonte panorâmica: vai para o par frontal, ou para o centro numa saída mono. */
+        if (in_channels == 1) {
+            uint32_t front = WAV_SPEAKER_FRONT_LEFT | WAV_SPEAKER_FRONT_RIGHT;
+            if ((out_mask & front) == front) {
+                column[speaker_index(out_mask, WAV_SPEAKER_FRONT_LEFT)] = 1.0f;
+                column[speaker_index(out_mask, WAV_SPEAKER_FRONT_RIGHT)] = 1.0f;
             } else {
-                fread(&chunk_size, 4, 1, files[i]);
-                fseek(files[i], chunk_size, SEEK_CUR);
+                route_speaker(WAV_SPEAKER_FRONT_CENTER, out_mask, column);
             }
+            continue;
         }
 
-        if (strncmp(headers[i].chunkID, "RIFF", 4) != 0 || 
-            strncmp(headers[i].format, "WAVE", 4) != 0) {
-            printf("Arquivo não é WAV válido: %s\n", input_files[i]);
-            fclose(files[i]);
-            for (int j = 0; j < i; j++) {
-                fclose(files[j]);
-                if (actual_paths[j] != input_files[j]) free(actual_paths[j]);
-            }
-            free(files); free(headers); free(fmts); free(datas); free(actual_paths);
-            return -1;
+        uint32_t speaker = channel_speaker(in_mask, ch);
+        if (speaker != 0) {
+            route_speaker(speaker, out_mask, column);
+        } else if (ch < out_channels) {
+            column[ch] = 1.0f;
         }
+    }
 
-        if (i == 0) {
-            sample_rate = fmts[i].sampleRate;
-            num_channels = fmts[i].numChannels;
-            bits_per_sample = fmts[i].bitsPerSample;
+    /* Pan de potência constante: esquerda recebe left_gain, direita right_gain, centro e LFE a média. */
+    float pan_rad = (pan + 1.0f) * M_PI / 4.0f;
+    float left_gain = volume * cosf(pan_rad);
+    float right_gain = volume * sinf(pan_rad);
+    float center_gain = (left_gain + right_gain) * 0.70710678f;
+    if (layout == MIX_LAYOUT_MONO) {
+        left_gain = right_gain = center_gain = volume;
+    }
+
+    for (uint16_t out = 0; out < out_channels; out++) {
+        uint32_t speaker = channel_speaker(out_mask, out);
+        float gain = (speaker & SPEAKER_LEFT_SIDE) ? left_gain
+                     : (speaker & SPEAKER_RIGHT_SIDE) ? right_gain : center_gain;
+        for (uint16_t ch = 0; ch < in_channels; ch++) {
+            matrix[(size_t)ch * out_channels + out] *= gain;
         }
+    }
+
+    return out_channels;
+}
+
+#define MIX_BLOCK_FRAMES 4096
+
+#define MIX_RANGE_FRAMES (MIX_BLOCK_FRAMES * 64)
+
+/* Duração da rampa de ganho depois de uma mudança de volume/pan (~11 ms a 44,1 kHz). */
+#define MIX_RAMP_FRAMES 512
+
+typedef struct {
+    WavReader reader;
+    const char* filename;
+    char* path;
+    float left_gain;
+    float right_gain;
+    Resampler resampler;  /* filters == NULL quando a taxa já é a da sessão */
+    uint64_t start;       /* início do clipe na linha do tempo, em quadros da sessão */
+    uint64_t frames;      /* duração na taxa da sessão */
+    float* matrix;        /* canais da entrada -> canais do barramento, ver mix_channel_matrix() */
+    int stereo_gains;     /* barramento estéreo e entrada mono/estéreo: usa left_gain/right_gain direto */
+    int clip_index;       /* posição do clipe em clips[] de mix_stream_open() */
+    float* ramp_from;     /* ganhos no início da rampa, no mesmo formato de matrix */
+    uint32_t ramp_left;   /* quadros que faltam até chegar em matrix */
+} MixInput;
+
+/* Buffers de trabalho de cada thread; "span" é o maior trecho de entrada lido por bloco. */
+typedef struct {
+    float* bus;
+    uint8_t* output;
+    uint8_t* samples;
+    float* convert;
+    float* planar;
+    float* resampled;
+    uint8_t* silence;     /* um bloco de saída já convertido de silêncio */
+    int* active;          /* entradas que tocam no trecho sendo renderizado */
+} MixScratch;
+
+/*
+ * Árvore de intervalos das entradas, para achar as que tocam num trecho em
+ * O(log n + k). Fica implícita num vetor ordenado pelo início: a raiz de
+ * [lo, hi) é o meio, e max_end[meio] é o maior fim dessa subárvore. Início,
+ * fim e max_end ficam em vetores separados, então a busca só lê o que compara.
+ */
+typedef struct {
+    uint64_t* start;
+    uint64_t* end;
+    uint64_t* max_end;
+    int* input;           /* posição em MixStream.inputs */
+} MixInputIndex;
+
+/* Clipes audíveis já abertos e o formato do barramento e da saída. */
+struct MixStream {
+    MixInput* inputs;
+    int input_count;
+    MixInputIndex index;
+    uint32_t sample_rate;
+    uint64_t total_frames;
+    uint16_t bus_channels;
+    uint32_t channel_mask;
+    MixChannelLayout layout;
+    uint16_t max_channels;
+    uint16_t max_block_align;
+    size_t max_span;
+    WavSampleFormat output_format;
+    uint16_t output_sample_bytes;
+    const MixKernels* kernels;
+    MixScratch scratch;   /* usado só por mix_stream_render() */
+};
+
+typedef struct {
+    MixStream* stream;
+    FILE* output;
+    int64_t output_offset;
+    pthread_mutex_t lock;
+    uint64_t next_frame;
+    int failed;
+} MixJob;
 
-        if (datas[i].subchunk2Size > max_data_size) {
-            max_data_size = datas[i].subchunk2Size;
+static int mix_thread_count(void) {
+#ifdef _WIN32
+    SYSTEM_INFO system_info;
+    GetSystemInfo(&system_info);
+    long count = system_info.dwNumberOfProcessors;
+#else
+    long count = sysconf(_SC_NPROCESSORS_ONLN);
+#endif
+    return count > 0 ? (int)count : 1;
+}
+
+static char* resolve_input_path(const char* filename) {
+    if (access(filename, F_OK) == 0) {
+        return (char*)filename;
+    }
+
+    const char *basename = strrchr(filename, '/');
+    if (!basename) basename = strrchr(filename, '\\');
+    if (basename) basename++;
+    else basename = filename;
+
+    const char *alternatives[] = {
+        "../audio/",
+        "audio/",
+        "./audio/",
+        NULL
+    };
+
+    for (int alt = 0; alternatives[alt] != NULL; alt++) {
+        size_t len = strlen(alternatives[alt]) + strlen(basename) + 1;
+        char *actual_path = malloc(len);
+        if (!actual_path) return NULL;
+        snprintf(actual_path, len, "%s%s", alternatives[alt], basename);
+
+        if (access(actual_path, F_OK) == 0) {
+            return actual_path;
         }
-        
+        free(actual_path);
     }
 
-    FILE* output = fopen(output_file, "wb");
-    if (!output) {
-        printf("Erro ao criar: %s\n", output_file);
-        for (int i = 0; i < file_count; i++) {
-            fclose(files[i]);
-            if (actual_paths[i] != input_files[i]) free(actual_paths[i]);
+    return NULL;
+}
+
+static void close_mix_inputs(MixInput* inputs, int count) {
+    for (int i = 0; i < count; i++) {
+        wav_reader_close(&inputs[i].reader);
+        resampler_free(&inputs[i].resampler);
+        free(inputs[i].matrix);
+        free(inputs[i].ramp_from);
+        if (inputs[i].path && inputs[i].path != inputs[i].filename) free(inputs[i].path);
+    }
+    free(inputs);
+}
+
+static int open_mix_input(MixInput* input, const char* filename) {
+    input->filename = filename;
+    input->path = resolve_input_path(filename);
+    if (!input->path) {
+        printf("Erro ao abrir: %s\n", filename);
+        return -1;
+    }
+
+    if (wav_reader_open(&input->reader, input->path, WAV_READER_MAP) != 0) {
+        printf("Arquivo não é WAV válido: %s\n", filename);
+        return -1;
+    }
+
+    if (input->reader.format == WAV_SAMPLE_UNSUPPORTED) {
+        printf("Formato de amostra não suportado (%u, %u bits): %s\n",
+               input->reader.info.audio_format, input->reader.info.bits_per_sample, filename);
+        return -1;
+    }
+
+    if (input->reader.info.duration_samples == 0) {
+        printf("Aviso: Nenhum dado lido de %s\n", filename);
+    }
+
+    return 0;
+}
+
+/*
+ * Soma o começo do bloco com o ganho indo linearmente de ramp_from até matrix,
+ * quadro a quadro, e devolve quantos quadros usou. A rampa é curta e rara, então
+ * fica no laço escalar.
+ */
+static size_t mix_ramp_block(const MixStream* stream, MixInput* input, const float* samples,
+                             size_t frames, float* mix_bus) {
+    size_t channels = input->reader.info.num_channels;
+    size_t bus_channels = stream->bus_channels;
+    size_t count = frames < input->ramp_left ? frames : input->ramp_left;
+    uint32_t done = MIX_RAMP_FRAMES - input->ramp_left;
+
+    for (size_t j = 0; j < count; j++) {
+        float t = (float)(done + j + 1) / MIX_RAMP_FRAMES;
+        const float* src = samples + j * channels;
+        float* bus = mix_bus + j * bus_channels;
+        for (size_t ch = 0; ch < channels; ch++) {
+            const float* from = input->ramp_from + ch * bus_channels;
+            const float* to = input->matrix + ch * bus_channels;
+            for (size_t out = 0; out < bus_channels; out++) {
+                bus[out] += src[ch] * (from[out] + (to[out] - from[out]) * t);
+            }
+        }
+    }
+
+    input->ramp_left -= (uint32_t)count;
+    return count;
+}
+
+/* Acumula quadros já em float (escala de 16 bits) no barramento. */
+static void mix_float_block(const MixStream* stream, MixInput* input, const float* samples,
+                            size_t frames, float* mix_bus) {
+    const MixKernels* kernels = stream->kernels;
+    size_t stride = input->reader.info.num_channels;
+
+    if (input->ramp_left > 0) {
+        size_t ramped = mix_ramp_block(stream, input, samples, frames, mix_bus);
+        samples += ramped * stride;
+        mix_bus += ramped * stream->bus_channels;
+        frames -= ramped;
+    }
+
+    if (input->stereo_gains && stride == 2) {
+        kernels->mix_stereo_f32(mix_bus, samples, frames, input->left_gain, input->right_gain);
+    } else if (input->stereo_gains) {
+        kernels->mix_mono_f32(mix_bus, samples, frames, input->left_gain, input->right_gain);
+    } else {
+        kernels->mix_matrix_f32(mix_bus, stream->bus_channels, samples, stride, frames, input->matrix);
+    }
+}
+
+/*
+ * Acumula um bloco de uma entrada no barramento em float, sem saturar.
+ * 16 bits mono/estéreo num barramento estéreo é somado direto; o resto é
+ * convertido antes para "convert" (quadros * canais floats).
+ */
+static void mix_input_block(const MixStream* stream, MixInput* input, const void* data,
+                            size_t frames, MixScratch* scratch, float* mix_bus) {
+    const MixKernels* kernels = stream->kernels;
+    size_t stride = input->reader.info.num_channels;
+
+    if (input->reader.format == WAV_SAMPLE_S16 && input->stereo_gains && input->ramp_left == 0) {
+        const int16_t* samples = (const int16_t*)data;
+        if (stride == 2) {
+            kernels->mix_stereo_s16(mix_bus, samples, frames, input->left_gain, input->right_gain);
+        } else {
+            kernels->mix_mono_s16(mix_bus, samples, frames, input->left_gain, input->right_gain);
+        }
+        return;
+    }
+
+    kernels->to_float[input->reader.format](scratch->convert, data, frames * stride);
+    mix_float_block(stream, input, scratch->convert, frames, mix_bus);
+}
+
+/*
+ * Reamostra "frames" quadros da entrada a partir de "frame" (taxa da sessão)
+ * para scratch->resampled. O trecho de entrada é lido uma vez, convertido e
+ * separado por canal; o que cai antes do início ou depois do fim é silêncio.
+ */
+static void resample_input_block(const MixStream* stream, const MixInput* input, uint64_t frame, size_t frames,
+                                 MixScratch* scratch) {
+    const WavReader* reader = &input->reader;
+    size_t channels = reader->info.num_channels;
+
+    int64_t first_input;
+    size_t span;
+    resampler_input_span(&input->resampler, frame, frames, &first_input, &span);
+
+    int64_t read_first = first_input < 0 ? 0 : first_input;
+    int64_t read_end = first_input + (int64_t)span;
+    if (read_end > (int64_t)reader->info.duration_samples) read_end = reader->info.duration_samples;
+    size_t lead = (size_t)(read_first - first_input);
+    size_t count = read_end > read_first ? (size_t)(read_end - read_first) : 0;
+
+    const uint8_t* data = scratch->samples;
+    if (reader->data) {
+        data = reader->data + (size_t)read_first * reader->block_align;
+    } else if (count > 0) {
+        count = wav_reader_read(reader, (uint64_t)read_first, scratch->samples, count);
+    }
+    stream->kernels->to_float[reader->format](scratch->convert, data, count * channels);
+
+    for (size_t ch = 0; ch < channels; ch++) {
+        float* plane = scratch->planar + ch * span;
+        memset(plane, 0, lead * sizeof(float));
+        for (size_t j = 0; j < count; j++) {
+            plane[lead + j] = scratch->convert[j * channels + ch];
         }
-        free(files); free(headers); free(fmts); free(datas); free(actual_paths);
+        memset(plane + lead + count, 0, (span - lead - count) * sizeof(float));
+
+        resampler_process(&input->resampler, stream->kernels, plane, first_input, frame, frames,
+                          scratch->resampled + ch, channels);
+    }
+}
+
+static int mix_scratch_init(const MixStream* stream, MixScratch* scratch) {
+    size_t bus_samples = MIX_BLOCK_FRAMES * stream->bus_channels;
+    scratch->bus = malloc(bus_samples * sizeof(float));
+    scratch->output = malloc(bus_samples * stream->output_sample_bytes);
+    scratch->samples = malloc(stream->max_span * stream->max_block_align);
+    scratch->convert = malloc(stream->max_span * stream->max_channels * sizeof(float));
+    scratch->planar = malloc(stream->max_span * stream->max_channels * sizeof(float));
+    scratch->resampled = malloc(MIX_BLOCK_FRAMES * stream->max_channels * sizeof(float));
+    scratch->silence = malloc(bus_samples * stream->output_sample_bytes);
+    scratch->active = malloc(stream->input_count * sizeof(int));
+
+    if (!scratch->bus || !scratch->output || !scratch->samples || !scratch->convert ||
+        !scratch->planar || !scratch->resampled || !scratch->silence || !scratch->active) {
         return -1;
     }
 
-    WAV_Header out_header = headers[0];
-    WAV_Fmt out_fmt = fmts[0];
-    WAV_Data out_data;
-    
-    out_data.subchunk2ID[0] = 'd';
-    out_data.subchunk2ID[1] = 'a';
-    out_data.subchunk2ID[2] = 't';
-    out_data.subchunk2ID[3] = 'a';
-    
-    out_data.subchunk2Size = max_data_size;
-    out_header.chunkSize = 36 + max_data_size;
+    memset(scratch->bus, 0, bus_samples * sizeof(float));
+    stream->kernels->from_float[stream->output_format](scratch->silence, scratch->bus, bus_samples);
+    return 0;
+}
 
-    fwrite(&out_header, sizeof(WAV_Header), 1, output);
-    fwrite(&out_fmt, sizeof(WAV_Fmt), 1, output);
-    fwrite(&out_data, sizeof(WAV_Data), 1, output);
+static void mix_scratch_free(MixScratch* scratch) {
+    free(scratch->bus);
+    free(scratch->output);
+    free(scratch->samples);
+    free(scratch->convert);
+    free(scratch->planar);
+    free(scratch->resampled);
+    free(scratch->silence);
+    free(scratch->active);
+}
 
-    for (int i = 0; i < file_count; i++) {
-        fclose(files[i]);
+typedef struct {
+    uint64_t start;
+    uint64_t end;
+    int input;
+} MixIndexEntry;
+
+static int compare_index_entries(const void* a, const void* b) {
+    const MixIndexEntry* left = (const MixIndexEntry*)a;
+    const MixIndexEntry* right = (const MixIndexEntry*)b;
+    if (left->start != right->start) return left->start < right->start ? -1 : 1;
+    return left->input - right->input;
+}
+
+/* Preenche max_end da subárvore [lo, hi) e devolve o maior fim dela. */
+static uint64_t build_index_max_end(MixInputIndex* index, int lo, int hi) {
+    if (lo >= hi) return 0;
+    int mid = lo + (hi - lo) / 2;
+    uint64_t max_end = index->end[mid];
+    uint64_t left = build_index_max_end(index, lo, mid);
+    uint64_t right = build_index_max_end(index, mid + 1, hi);
+    if (left > max_end) max_end = left;
+    if (right > max_end) max_end = right;
+    index->max_end[mid] = max_end;
+    return max_end;
+}
+
+static int build_input_index(MixStream* stream) {
+    int count = stream->input_count;
+    MixInputIndex* index = &stream->index;
+    MixIndexEntry* entries = malloc(count * sizeof(MixIndexEntry));
+    index->start = malloc(count * sizeof(uint64_t));
+    index->end = malloc(count * sizeof(uint64_t));
+    index->max_end = malloc(count * sizeof(uint64_t));
+    index->input = malloc(count * sizeof(int));
+    if (!entries || !index->start || !index->end || !index->max_end || !index->input) {
+        free(entries);
+        return -1;
     }
 
-    size_t max_samples = max_data_size / sizeof(int16_t);
-    int16_t* mix_buffer = calloc(max_samples, sizeof(int16_t));
-    int16_t* sample_buffer = malloc(max_data_size);
+    for (int i = 0; i < count; i++) {
+        entries[i].start = stream->inputs[i].start;
+        entries[i].end = stream->inputs[i].start + stream->inputs[i].frames;
+        entries[i].input = i;
+    }
+    qsort(entries, count, sizeof(MixIndexEntry), compare_index_entries);
 
-    for (int i = 0; i < file_count; i++) {
-        files[i] = fopen(actual_paths[i], "rb");
-        if (!files[i]) {
-            printf("Erro ao reabrir: %s\n", actual_paths[i]);
-            continue;
+    for (int i = 0; i < count; i++) {
+        index->start[i] = entries[i].start;
+        index->end[i] = entries[i].end;
+        index->input[i] = entries[i].input;
+    }
+    build_index_max_end(index, 0, count);
+    free(entries);
+    return 0;
+}
+
+static void free_input_index(MixInputIndex* index) {
+    free(index->start);
+    free(index->end);
+    free(index->max_end);
+    free(index->input);
+}
+
+/*
+ * Junta em active as entradas de [lo, hi) que tocam em [first_frame, end_frame).
+ * Subárvores que acabam antes do trecho são puladas pelo max_end; à direita de
+ * um início depois do trecho não há mais nada.
+ */
+static void query_input_index(const MixInputIndex* index, int lo, int hi, uint64_t first_frame,
+                              uint64_t end_frame, int* active, int* active_count) {
+    while (lo < hi) {
+        int mid = lo + (hi - lo) / 2;
+        if (index->max_end[mid] <= first_frame) return;
+
+        query_input_index(index, lo, mid, first_frame, end_frame, active, active_count);
+        if (index->start[mid] >= end_frame) return;
+        if (index->end[mid] > first_frame) {
+            active[(*active_count)++] = index->input[mid];
         }
-        
-        fseek(files[i], sizeof(WAV_Header) + sizeof(WAV_Fmt), SEEK_SET);
-        
-        char chunk_id[4];
-        uint32_t chunk_size;
-        while (fread(chunk_id, 4, 1, files[i]) == 1) {
-            if (strncmp(chunk_id, "data", 4) == 0) {
-                fread(&chunk_size, 4, 1, files[i]);
-                break;
-            } else {
-                fread(&chunk_size, 4, 1, files[i]);
-                fseek(files[i], chunk_size, SEEK_CUR);
-            }
+        lo = mid + 1;
+    }
+}
+
+/*
+ * Guarda em scratch->active as entradas que tocam em [first_frame, end_frame),
+ * na ordem das entradas: a soma no barramento sai igual à de antes do índice.
+ */
+static int collect_active_inputs(const MixStream* stream, uint64_t first_frame, uint64_t end_frame,
+                                 MixScratch* scratch) {
+    int active_count = 0;
+    query_input_index(&stream->index, 0, stream->input_count, first_frame, end_frame,
+                      scratch->active, &active_count);
+
+    for (int i = 1; i < active_count; i++) {
+        int input = scratch->active[i];
+        int j = i;
+        for (; j > 0 && scratch->active[j - 1] > input; j--) {
+            scratch->active[j] = scratch->active[j - 1];
         }
-        
-        size_t samples_read = fread(sample_buffer, 1, datas[i].subchunk2Size, files[i]);
-        size_t sample_count = samples_read / sizeof(int16_t);
-        
-        if (samples_read == 0) {
-            printf("Aviso: Nenhum dado lido de %s\n", input_files[i]);
-            fclose(files[i]);
+        scratch->active[j] = input;
+    }
+    return active_count;
+}
+
+/*
+ * Mixa um bloco de até MIX_BLOCK_FRAMES quadros a partir de "frame" em "dst",
+ * já no formato de saída. Cada clipe de scratch->active só é lido nos quadros
+ * em que está tocando; se nenhum toca no bloco, a mixagem e a conversão são
+ * puladas e o retorno é scratch->silence em vez de dst.
+ */
+static const uint8_t* render_mix_block(const MixStream* stream, MixScratch* scratch, int active_count,
+                                       uint64_t frame, size_t block_frames, uint8_t* dst) {
+    uint64_t block_end = frame + block_frames;
+    int mixed = 0;
+
+    for (int a = 0; a < active_count; a++) {
+        MixInput* input = &stream->inputs[scratch->active[a]];
+        const WavReader* reader = &input->reader;
+        uint64_t clip_end = input->start + input->frames;
+        if (input->start >= block_end || clip_end <= frame) continue;
+
+        if (!mixed) {
+            memset(scratch->bus, 0, block_frames * stream->bus_channels * sizeof(float));
+            mixed = 1;
+        }
+
+        uint64_t first = input->start > frame ? input->start : frame;
+        uint64_t last = clip_end < block_end ? clip_end : block_end;
+        size_t frames_to_read = (size_t)(last - first);
+        uint64_t source_frame = first - input->start;
+        float* mix_bus = scratch->bus + (size_t)(first - frame) * stream->bus_channels;
+
+        if (input->resampler.filters) {
+            resample_input_block(stream, input, source_frame, frames_to_read, scratch);
+            mix_float_block(stream, input, scratch->resampled, frames_to_read, mix_bus);
             continue;
         }
-        
-        float pan = (pans != NULL) ? pans[i] : 0.0f;
-        float pan_rad = (pan + 1.0f) * M_PI / 4.0f;
-        float left_gain = cosf(pan_rad);
-        float right_gain = sinf(pan_rad);
-
-        if (num_channels == 2) {
-            for (size_t j = 0; j < sample_count && j < max_samples; j += 2) {
-                float left = sample_buffer[j] * volumes[i];
-                float right = sample_buffer[j + 1] * volumes[i];
-                
-                left *= left_gain;
-                right *= right_gain;
-                
-                float mixed_left = mix_buffer[j] + left;
-                float mixed_right = mix_buffer[j + 1] + right;
-                
-                if (mixed_left > 32767) mixed_left = 32767;
-                if (mixed_left < -32768) mixed_left = -32768;
-                if (mixed_right > 32767) mixed_right = 32767;
-                if (mixed_right < -32768) mixed_right = -32768;
-                
-                mix_buffer[j] = (int16_t)mixed_left;
-                mix_buffer[j + 1] = (int16_t)mixed_right;
-            }
-        } else {
-            for (size_t j = 0; j < sample_count && (j * 2) < max_samples; j++) {
-                float sample = sample_buffer[j] * volumes[i];
-                
-                float left = sample * left_gain;
-                float right = sample * right_gain;
-                
-                size_t left_idx = j * 2;
-                size_t right_idx = j * 2 + 1;
-                
-                if (left_idx < max_samples) {
-                    float mixed_left = mix_buffer[left_idx] + left;
-                    if (mixed_left > 32767) mixed_left = 32767;
-                    if (mixed_left < -32768) mixed_left = -32768;
-                    mix_buffer[left_idx] = (int16_t)mixed_left;
-                }
-                
-                if (right_idx < max_samples) {
-                    float mixed_right = mix_buffer[right_idx] + right;
-                    if (mixed_right > 32767) mixed_right = 32767;
-                    if (mixed_right < -32768) mixed_right = -32768;
-                    mix_buffer[right_idx] = (int16_t)mixed_right;
-                }
-            }
+
+        if (reader->data) {
+            const uint8_t* data = reader->data + (size_t)source_frame * reader->block_align;
+            mix_input_block(stream, input, data, frames_to_read, scratch, mix_bus);
+            continue;
         }
 
-        fclose(files[i]);
+        size_t frames_read = wav_reader_read(reader, source_frame, scratch->samples, frames_to_read);
+        mix_input_block(stream, input, scratch->samples, frames_read, scratch, mix_bus);
     }
 
-    size_t written = fwrite(mix_buffer, 1, max_data_size, output);
-    if (written != max_data_size) {
-    }
+    if (!mixed) return scratch->silence;
 
-    fclose(output);
-    free(mix_buffer);
-    free(sample_buffer);
-    for (int i = 0; i < file_count; i++) {
-        if (actual_paths[i] != input_files[i]) {
-            free(actual_paths[i]);
+    stream->kernels->from_float[stream->output_format](dst, scratch->bus, block_frames * stream->bus_channels);
+    return dst;
+}
+
+/* Renderiza [first_frame, end_frame) da linha do tempo direto no arquivo de saída. */
+static int render_mix_range(MixJob* job, uint64_t first_frame, uint64_t end_frame, MixScratch* scratch) {
+    const MixStream* stream = job->stream;
+    int active_count = collect_active_inputs(stream, first_frame, end_frame, scratch);
+    size_t out_frame_bytes = stream->bus_channels * stream->output_sample_bytes;
+
+    for (uint64_t frame = first_frame; frame < end_frame; frame += MIX_BLOCK_FRAMES) {
+        size_t block_frames = (end_frame - frame > MIX_BLOCK_FRAMES) ? MIX_BLOCK_FRAMES : (size_t)(end_frame - frame);
+        const uint8_t* block = render_mix_block(stream, scratch, active_count, frame, block_frames, scratch->output);
+
+        size_t out_bytes = block_frames * out_frame_bytes;
+        if (write_at(job->output, block, out_bytes,
+                     job->output_offset + (int64_t)frame * out_frame_bytes) != out_bytes) {
+            return -1;
         }
     }
-    free(actual_paths);
-    free(files);
-    free(headers);
-    free(fmts);
-    free(datas);
 
     return 0;
 }
 
-int get_wav_info(const char* filename, WAV_Info* info) {
-    if (!filename || !info) return -1;
-    
-    FILE* file = fopen(filename, "rb");
-    if (!file) return -1;
-    
+/* Cada thread pega o próximo trecho livre da linha do tempo e grava a sua fatia da saída. */
+static void* mix_worker(void* arg) {
+    MixJob* job = (MixJob*)arg;
+    uint64_t total_frames = job->stream->total_frames;
+
+    MixScratch scratch;
+    int failed = mix_scratch_init(job->stream, &scratch) != 0;
+    while (!failed) {
+        pthread_mutex_lock(&job->lock);
+        failed = job->failed;
+        uint64_t first_frame = job->next_frame;
+        if (!failed && first_frame < total_frames) {
+            job->next_frame = (total_frames - first_frame > MIX_RANGE_FRAMES)
+                              ? first_frame + MIX_RANGE_FRAMES : total_frames;
+        }
+        uint64_t end_frame = job->next_frame;
+        pthread_mutex_unlock(&job->lock);
+
+        if (failed || first_frame >= end_frame) break;
+
+        failed = render_mix_range(job, first_frame, end_frame, &scratch) != 0;
+    }
+
+    if (failed) {
+        pthread_mutex_lock(&job->lock);
+        job->failed = 1;
+        pthread_mutex_unlock(&job->lock);
+    }
+
+    mix_scratch_free(&scratch);
+    return NULL;
+}
+
+/*
+ * Grava o cabeçalho da saída e devolve o seu tamanho em bytes (ou -1).
+ * Até 16 bits usa o fmt PCM simples; 24/32 bits e float usam
+ * WAVE_FORMAT_EXTENSIBLE, como pede a especificação, assim como mais de dois
+ * canais. Se o arquivo passar de 4 GB o cabeçalho vira RF64, com os tamanhos
+ * reais no chunk "ds64". Com data ímpar, o byte de preenchimento que o RIFF
+ * exige já é gravado depois dos dados e entra no tamanho do arquivo.
+ */
+static int64_t write_wav_header(FILE* output, WavSampleFormat format, uint16_t channels, uint32_t channel_mask,
+                                uint32_t sample_rate, uint64_t frames) {
+    int extensible = (format != WAV_SAMPLE_U8 && format != WAV_SAMPLE_S16) || channels > 2;
+    uint16_t sample_bytes = wav_sample_bytes(format);
+    uint64_t data_size = frames * channels * sample_bytes;
+    uint64_t pad = data_size & 1;
+    int64_t header_size = sizeof(WAV_Header) + sizeof(WAV_Fmt) + sizeof(WAV_Data) +
+                          (extensible ? sizeof(WAV_FmtExtensible) : 0);
+    int rf64 = header_size - 8 + data_size + pad > RIFF_SIZE_LIMIT;
+    if (rf64) header_size += sizeof(WAV_DS64);
+
     WAV_Header header;
+    memcpy(header.chunkID, rf64 ? "RF64" : "RIFF", 4);
+    memcpy(header.format, "WAVE", 4);
+    header.chunkSize = rf64 ? RIFF_SIZE_LIMIT : (uint32_t)(header_size - 8 + data_size + pad);
+
+    WAV_DS64 ds64;
+    memcpy(ds64.chunkID, "ds64", 4);
+    ds64.chunkSize = sizeof(WAV_DS64) - 8;
+    ds64.riffSize = header_size - 8 + data_size + pad;
+    ds64.dataSize = data_size;
+    ds64.sampleCount = frames;
+    ds64.tableLength = 0;
+
     WAV_Fmt fmt;
-    
-    if (fread(&header, sizeof(WAV_Header), 1, file) != 1) {
-        fclose(file);
+    memcpy(fmt.subchunk1ID, "fmt ", 4);
+    fmt.subchunk1Size = 16 + (extensible ? sizeof(WAV_FmtExtensible) : 0);
+    fmt.audioFormat = extensible ? WAV_FORMAT_EXTENSIBLE : WAV_FORMAT_PCM;
+    fmt.numChannels = channels;
+    fmt.sampleRate = sample_rate;
+    fmt.bitsPerSample = sample_bytes * 8;
+    fmt.blockAlign = channels * sample_bytes;
+    fmt.byteRate = sample_rate * fmt.blockAlign;
+
+    WAV_FmtExtensible ext;
+    uint16_t subformat = (format == WAV_SAMPLE_F32) ? WAV_FORMAT_IEEE_FLOAT : WAV_FORMAT_PCM;
+    ext.cbSize = sizeof(WAV_FmtExtensible) - 2;
+    ext.validBitsPerSample = fmt.bitsPerSample;
+    ext.channelMask = channel_mask;
+    memcpy(ext.subFormat, &subformat, 2);
+    memcpy(ext.subFormat + 2, wav_subformat_tail, sizeof(wav_subformat_tail));
+
+    WAV_Data data;
+    memcpy(data.subchunk2ID, "data", 4);
+    data.subchunk2Size = rf64 ? RIFF_SIZE_LIMIT : (uint32_t)data_size;
+
+    if (fwrite(&header, sizeof(WAV_Header), 1, output) != 1 ||
+        (rf64 && fwrite(&ds64, sizeof(WAV_DS64), 1, output) != 1) ||
+        fwrite(&fmt, sizeof(WAV_Fmt), 1, output) != 1 ||
+        (extensible && fwrite(&ext, sizeof(WAV_FmtExtensible), 1, output) != 1) ||
+        fwrite(&data, sizeof(WAV_Data), 1, output) != 1 ||
+        fflush(output) != 0) {
         return -1;
     }
-    
-    if (fread(&fmt, sizeof(WAV_Fmt), 1, file) != 1) {
-        fclose(file);
+
+    static const uint8_t pad_byte = 0;
+    if (pad && write_at(output, &pad_byte, 1, header_size + (int64_t)data_size) != 1) {
         return -1;
     }
-    
-    if (strncmp(header.chunkID, "RIFF", 4) != 0 || 
-        strncmp(header.format, "WAVE", 4) != 0) {
-        fclose(file);
+
+    return header_size;
+}
+
+/* Mono/estéreo num barramento estéreo: a matriz é só um ganho por lado. */
+static void update_stereo_gains(MixInput* input) {
+    if (input->stereo_gains) {
+        input->left_gain = input->matrix[0];
+        input->right_gain = input->matrix[input->reader.info.num_channels == 2 ? 3 : 1];
+    }
+}
+
+static void close_mix_stream_inputs(MixStream* stream) {
+    close_mix_inputs(stream->inputs, stream->input_count);
+    free_input_index(&stream->index);
+    free(stream);
+}
+
+/*
+ * Abre os clipes audíveis e prepara a mixagem: clipes mudos (ou fora do solo)
+ * não são nem abertos. A saída está na taxa de amostragem do primeiro clipe
+ * audível, no layout de canais options->channel_layout e no formato
+ * options->sample_format (estéreo 16 bits se options for NULL); cada entrada
+ * chega ao barramento pela sua matriz de canais (mix_channel_matrix). As
+ * entradas podem ser de 8, 16, 24 ou 32 bits inteiros ou float de 32 bits,
+ * misturadas; as que têm outra taxa são reamostradas bloco a bloco com
+ * options->resample_quality.
+ */
+MixStream* mix_stream_open(const MixClip clips[], int clip_count, const MixOptions* options) {
+    if (clip_count == 0) {
+        printf("Erro: Nenhum arquivo para mixar\n");
+        return NULL;
+    }
+
+    WavSampleFormat output_format = options ? options->sample_format : WAV_SAMPLE_S16;
+    ResampleQuality quality = options ? options->resample_quality : RESAMPLE_MEDIUM;
+    MixChannelLayout layout = options ? options->channel_layout : MIX_LAYOUT_STEREO;
+    uint16_t bus_channels = mix_layout_channels(layout);
+    if (bus_channels == 0) {
+        printf("Erro: Layout de canais não suportado\n");
+        return NULL;
+    }
+    if (wav_sample_bytes(output_format) == 0) {
+        printf("Erro: Formato de saída não suportado\n");
+        return NULL;
+    }
+
+    int any_solo = 0;
+    for (int i = 0; i < clip_count; i++) {
+        if (clips[i].solo) any_solo = 1;
+    }
+
+    MixStream* stream = calloc(1, sizeof(MixStream));
+    if (!stream) return NULL;
+    stream->inputs = calloc(clip_count, sizeof(MixInput));
+    const MixClip** sources = malloc(clip_count * sizeof(MixClip*));
+    if (!stream->inputs || !sources) {
+        free(sources);
+        close_mix_stream_inputs(stream);
+        return NULL;
+    }
+
+    /* Só os clipes audíveis viram entradas. */
+    MixInput* inputs = stream->inputs;
+    for (int i = 0; i < clip_count; i++) {
+        if (clips[i].muted || (any_solo && !clips[i].solo)) continue;
+        sources[stream->input_count] = &clips[i];
+        inputs[stream->input_count].clip_index = i;
+        if (open_mix_input(&inputs[stream->input_count++], clips[i].filename) != 0) {
+            free(sources);
+            close_mix_stream_inputs(stream);
+            return NULL;
+        }
+    }
+
+    if (stream->input_count == 0) {
+        printf("Erro: Nenhum clipe audível para mixar\n");
+        free(sources);
+        close_mix_stream_inputs(stream);
+        return NULL;
+    }
+
+    uint32_t sample_rate = inputs[0].reader.info.sample_rate;
+    uint64_t max_frames = 0;
+    uint16_t max_channels = 1;
+    uint16_t max_block_align = 1;
+    size_t max_span = MIX_BLOCK_FRAMES;
+    for (int i = 0; i < stream->input_count; i++) {
+        const MixClip* clip = sources[i];
+        const WAV_Info* info = &inputs[i].reader.info;
+        inputs[i].matrix = malloc((size_t)info->num_channels * bus_channels * sizeof(float));
+        if (!inputs[i].matrix || mix_channel_matrix(info, layout, clip->volume, clip->pan, inputs[i].matrix) < 0) {
+            free(sources);
+            close_mix_stream_inputs(stream);
+            return NULL;
+        }
+
+        inputs[i].stereo_gains = bus_channels == 2 && info->num_channels <= 2;
+        update_stereo_gains(&inputs[i]);
+
+        inputs[i].frames = info->duration_samples;
+        if (info->sample_rate != sample_rate) {
+            if (resampler_init(&inputs[i].resampler, info->sample_rate, sample_rate, quality) != 0) {
+                printf("Erro ao preparar reamostragem: %s\n", clip->filename);
+                free(sources);
+                close_mix_stream_inputs(stream);
+                return NULL;
+            }
+            inputs[i].frames = resampler_output_frames(&inputs[i].resampler, info->duration_samples);
+            size_t span = resampler_max_span(&inputs[i].resampler, MIX_BLOCK_FRAMES);
+            if (span > max_span) max_span = span;
+        }
+
+        if (clip->start_seconds > 0) {
+            inputs[i].start = (uint64_t)llround(clip->start_seconds * sample_rate);
+        }
+        if (clip->length_seconds > 0) {
+            uint64_t length = (uint64_t)llround(clip->length_seconds * sample_rate);
+            if (length < inputs[i].frames) inputs[i].frames = length;
+        }
+
+        if (inputs[i].start + inputs[i].frames > max_frames) max_frames = inputs[i].start + inputs[i].frames;
+        if (info->num_channels > max_channels) max_channels = info->num_channels;
+        if (inputs[i].reader.block_align > max_block_align) max_block_align = inputs[i].reader.block_align;
+    }
+    free(sources);
+
+    stream->sample_rate = sample_rate;
+    stream->total_frames = max_frames;
+    stream->bus_channels = bus_channels;
+    stream->channel_mask = mix_layout_mask(layout);
+    stream->layout = layout;
+    stream->max_channels = max_channels;
+    stream->max_block_align = max_block_align;
+    stream->max_span = max_span;
+    stream->output_format = output_format;
+    stream->output_sample_bytes = wav_sample_bytes(output_format);
+    stream->kernels = mix_kernels_get();
+
+    if (build_input_index(stream) != 0 || mix_scratch_init(stream, &stream->scratch) != 0) {
+        mix_stream_close(stream);
+        return NULL;
+    }
+
+    return stream;
+}
+
+/*
+ * Mixa "frames" quadros a partir de first_frame em "output", no formato de
+ * saída e intercalado. Depois do fim da linha do tempo é só silêncio. Não usa
+ * threads nem grava nada, então serve para tocar direto no callback de áudio;
+ * só uma thread por vez pode chamar esta função para o mesmo stream.
+ */
+void mix_stream_render(MixStream* stream, uint64_t first_frame, void* output, size_t frames) {
+    MixScratch* scratch = &stream->scratch;
+    size_t frame_bytes = stream->bus_channels * stream->output_sample_bytes;
+    uint8_t* dst = (uint8_t*)output;
+
+    while (frames > 0) {
+        size_t block_frames = frames > MIX_BLOCK_FRAMES ? MIX_BLOCK_FRAMES : frames;
+        int active_count = collect_active_inputs(stream, first_frame, first_frame + block_frames, scratch);
+        const uint8_t* block = render_mix_block(stream, scratch, active_count, first_frame, block_frames, dst);
+        if (block != dst) memcpy(dst, block, block_frames * frame_bytes);
+
+        first_frame += block_frames;
+        dst += block_frames * frame_bytes;
+        frames -= block_frames;
+    }
+}
+
+/*
+ * Muda volume e pan do clipe clip_index (posição em clips[] de
+ * mix_stream_open()) no meio da reprodução. O ganho vai do valor que está
+ * tocando agora até o novo em MIX_RAMP_FRAMES quadros, a partir do próximo
+ * quadro renderizado, sem degrau audível. Devolve -1 se o clipe não está no
+ * stream (mudo ou fora do solo). Chamar da mesma thread que renderiza.
+ */
+int mix_stream_set_gain(MixStream* stream, int clip_index, float volume, float pan) {
+    for (int i = 0; i < stream->input_count; i++) {
+        MixInput* input = &stream->inputs[i];
+        if (input->clip_index != clip_index) continue;
+
+        size_t size = (size_t)input->reader.info.num_channels * stream->bus_channels;
+        if (!input->ramp_from) {
+            input->ramp_from = malloc(size * sizeof(float));
+            if (!input->ramp_from) return -1;
+        }
+
+        /* A rampa nova parte do ganho atual, mesmo que outra rampa esteja no meio. */
+        float left = (float)input->ramp_left / MIX_RAMP_FRAMES;
+        for (size_t k = 0; k < size; k++) {
+            float from = input->ramp_left > 0 ? input->ramp_from[k] : input->matrix[k];
+            input->ramp_from[k] = input->matrix[k] + (from - input->matrix[k]) * left;
+        }
+
+        if (mix_channel_matrix(&input->reader.info, stream->layout, volume, pan, input->matrix) < 0) {
+            input->ramp_left = 0;
+            return -1;
+        }
+        update_stereo_gains(input);
+        input->ramp_left = MIX_RAMP_FRAMES;
+        return 0;
+    }
+
+    return -1;
+}
+
+uint32_t mix_stream_sample_rate(const MixStream* stream) {
+    return stream->sample_rate;
+}
+
+uint16_t mix_stream_channels(const MixStream* stream) {
+    return stream->bus_channels;
+}
+
+uint64_t mix_stream_frames(const MixStream* stream) {
+    return stream->total_frames;
+}
+
+void mix_stream_close(MixStream* stream) {
+    if (!stream) return;
+    mix_scratch_free(&stream->scratch);
+    close_mix_stream_inputs(stream);
+}
+
+/*
+ * Mixa os clipes para um arquivo em blocos de MIX_BLOCK_FRAMES quadros: cada
+ * bloco é lido dos clipes que tocam nele, acumulado num barramento em float e
+ * convertido para o formato de saída uma única vez antes de ser gravado, então
+ * a memória usada depende só do tamanho do bloco e não há saturação
+ * intermediária entre as entradas. Trechos sem clipe ativo custam só a
+ * gravação do silêncio.
+ * A linha do tempo é dividida em trechos de MIX_RANGE_FRAMES quadros,
+ * renderizados em paralelo por uma thread por núcleo.
+ */
+int mix_clips(const char* output_file, const MixClip clips[], int clip_count, const MixOptions* options) {
+    MixStream* stream = mix_stream_open(clips, clip_count, options);
+    if (!stream) return -1;
+
+    FILE* output = fopen(output_file, "wb");
+    if (!output) {
+        printf("Erro ao criar: %s\n", output_file);
+        mix_stream_close(stream);
         return -1;
     }
-    
-    char chunk_id[4];
-    uint32_t chunk_size;
-    uint32_t data_size = 0;
-    
-    while (fread(chunk_id, 4, 1, file) == 1) {
-        if (strncmp(chunk_id, "data", 4) == 0) {
-            fread(&chunk_size, 4, 1, file);
-            data_size = chunk_size;
-            break;
-        } else {
-            fread(&chunk_size, 4, 1, file);
-            fseek(file, chunk_size, SEEK_CUR);
+
+    int64_t header_size = write_wav_header(output, stream->output_format, stream->bus_channels, stream->channel_mask,
+                                           stream->sample_rate, stream->total_frames);
+    if (header_size < 0) {
+        printf("Erro ao gravar: %s\n", output_file);
+        fclose(output);
+        mix_stream_close(stream);
+        return -1;
+    }
+
+    MixJob job;
+    job.stream = stream;
+    job.output = output;
+    job.output_offset = header_size;
+    job.next_frame = 0;
+    job.failed = 0;
+    pthread_mutex_init(&job.lock, NULL);
+
+    int thread_count = mix_thread_count();
+    uint64_t range_count = (stream->total_frames + MIX_RANGE_FRAMES - 1) / MIX_RANGE_FRAMES;
+    if ((uint64_t)thread_count > range_count) thread_count = range_count > 0 ? (int)range_count : 1;
+
+    pthread_t* threads = malloc(thread_count * sizeof(pthread_t));
+    int started = 0;
+    if (threads) {
+        for (; started < thread_count - 1; started++) {
+            if (pthread_create(&threads[started], NULL, mix_worker, &job) != 0) break;
         }
     }
+    mix_worker(&job);
+    for (int t = 0; t < started; t++) {
+        pthread_join(threads[t], NULL);
+    }
+    free(threads);
+    pthread_mutex_destroy(&job.lock);
+
+    int result = 0;
+    if (job.failed) {
+        printf("Erro ao gravar: %s\n", output_file);
+        result = -1;
+    }
+
+    fclose(output);
+    mix_stream_close(stream);
+
+    return result;
+}
+
+/* Todos os arquivos a partir do início da linha do tempo, sem mudo nem solo. */
+int mix_wav_files_ex(const char* output_file, const char* input_files[], float volumes[], float pans[], int file_count,
+                     const MixOptions* options) {
+    if (file_count == 0) {
+        printf("Erro: Nenhum arquivo para mixar\n");
+        return -1;
+    }
+
+    MixClip* clips = calloc(file_count, sizeof(MixClip));
+    if (!clips) return -1;
+
+    for (int i = 0; i < file_count; i++) {
+        clips[i].filename = input_files[i];
+        clips[i].volume = volumes[i];
+        clips[i].pan = (pans != NULL) ? pans[i] : 0.0f;
+    }
+
+    int result = mix_clips(output_file, clips, file_count, options);
+    free(clips);
+    return result;
+}
+
+int mix_wav_files(const char* output_file, const char* input_files[], float volumes[], float pans[], int file_count) {
+    return mix_wav_files_ex(output_file, input_files, volumes, pans, file_count, NULL);
+}
+
+int get_wav_info(const char* filename, WAV_Info* info) {
+    if (!filename || !info) return -1;
     
-    fclose(file);
+    WavReader reader;
+    if (wav_reader_open(&reader, filename, 0) != 0) return -1;
     
-    if (data_size == 0) return -1;
+    *info = reader.info;
+    wav_reader_close(&reader);
     
-    info->sample_rate = fmt.sampleRate;
-    info->num_channels = fmt.numChannels;
-    info->bits_per_sample = fmt.bitsPerSample;
-    info->data_size = data_size;
-    info->duration_samples = data_size / (fmt.numChannels * (fmt.bitsPerSample / 8));
+    if (info->data_size == 0) return -1;
     
     return 0;
 }
@@ -356,84 +1453,72 @@ int get_wav_info(const char* filename, WAV_Info* info) {
 int read_wav_samples(const char* filename, int16_t** samples, size_t* sample_count, int max_samples) {
     if (!filename || !samples || !sample_count) return -1;
     
-    FILE* file = fopen(filename, "rb");
-    if (!file) return -1;
-    
-    WAV_Header header;
-    WAV_Fmt fmt;
-    
-    if (fread(&header, sizeof(WAV_Header), 1, file) != 1) {
-        fclose(file);
-        return -1;
-    }
-    
-    if (fread(&fmt, sizeof(WAV_Fmt), 1, file) != 1) {
-        fclose(file);
+    WavReader reader;
+    if (wav_reader_open(&reader, filename, WAV_READER_MAP) != 0) return -1;
+    if (reader.format == WAV_SAMPLE_UNSUPPORTED) {
+        wav_reader_close(&reader);
         return -1;
     }
     
-    if (strncmp(header.chunkID, "RIFF", 4) != 0 || 
-        strncmp(header.format, "WAVE", 4) != 0) {
-        fclose(file);
-        return -1;
-    }
+    uint16_t channels = reader.info.num_channels;
+    size_t max_frames = (max_samples > 0) ? (size_t)max_samples : (1024 * 1024) / reader.block_align;
+    size_t frames = (reader.info.duration_samples > max_frames) ? max_frames : (size_t)reader.info.duration_samples;
     
-    char chunk_id[4];
-    uint32_t chunk_size;
-    long data_start = 0;
-    
-    while (fread(chunk_id, 4, 1, file) == 1) {
-        if (strncmp(chunk_id, "data", 4) == 0) {
-            fread(&chunk_size, 4, 1, file);
-            data_start = ftell(file);
-            break;
-        } else {
-            fread(&chunk_size, 4, 1, file);
-            fseek(file, chunk_size, SEEK_CUR);
+    /* Sem mapeamento, lê o trecho uma vez para um buffer temporário. */
+    const uint8_t* data = reader.data;
+    uint8_t* buffer = NULL;
+    if (!data) {
+        buffer = malloc(frames > 0 ? frames * reader.block_align : 1);
+        if (!buffer) {
+            wav_reader_close(&reader);
+            return -1;
         }
+        frames = wav_reader_read(&reader, 0, buffer, frames);
+        data = buffer;
     }
     
-    if (data_start == 0) {
-        fclose(file);
-        return -1;
-    }
-    
-    size_t bytes_to_read = chunk_size;
-    if (max_samples > 0) {
-        size_t max_bytes = max_samples * fmt.numChannels * sizeof(int16_t);
-        if (bytes_to_read > max_bytes) {
-            bytes_to_read = max_bytes;
-        }
-    } else {
-        if (bytes_to_read > 1024 * 1024) {
-            bytes_to_read = 1024 * 1024;
+    /* Outros formatos passam pela escala do barramento e voltam para 16 bits. */
+    if (reader.format != WAV_SAMPLE_S16) {
+        const MixKernels* kernels = mix_kernels_get();
+        size_t count = frames * channels;
+        float* scratch = malloc(count > 0 ? count * sizeof(float) : 1);
+        int16_t* converted = malloc(count > 0 ? count * sizeof(int16_t) : 1);
+        if (!scratch || !converted) {
+            free(scratch);
+            free(converted);
+            free(buffer);
+            wav_reader_close(&reader);
+            return -1;
         }
+        kernels->to_float[reader.format](scratch, data, count);
+        kernels->float_to_s16(converted, scratch, count);
+        free(scratch);
+        free(buffer);
+        buffer = (uint8_t*)converted;
+        data = buffer;
     }
     
-    *samples = malloc(bytes_to_read);
-    if (!*samples) {
-        fclose(file);
-        return -1;
-    }
-    
-    fseek(file, data_start, SEEK_SET);
-    size_t bytes_read = fread(*samples, 1, bytes_to_read, file);
-    *sample_count = bytes_read / sizeof(int16_t);
-    
-    if (fmt.numChannels == 2 && *sample_count > 0) {
-        int16_t* mono_samples = malloc((*sample_count / 2) * sizeof(int16_t));
-        if (mono_samples) {
-            for (size_t i = 0; i < *sample_count / 2; i++) {
-                mono_samples[i] = ((*samples)[i * 2] + (*samples)[i * 2 + 1]) / 2;
+    const int16_t* source = (const int16_t*)data;
+    if (channels == 2) {
+        *samples = malloc(frames > 0 ? frames * sizeof(int16_t) : 1);
+        if (*samples) {
+            for (size_t i = 0; i < frames; i++) {
+                (*samples)[i] = (source[i * 2] + source[i * 2 + 1]) / 2;
             }
-            free(*samples);
-            *samples = mono_samples;
-            *sample_count = *sample_count / 2;
         }
+        *sample_count = frames;
+        free(buffer);
+    } else if (buffer) {
+        *samples = (int16_t*)buffer;
+        *sample_count = frames * channels;
+    } else {
+        *samples = malloc(frames > 0 ? frames * channels * sizeof(int16_t) : 1);
+        if (*samples) memcpy(*samples, source, frames * channels * sizeof(int16_t));
+        *sample_count = frames * channels;
     }
     
-    fclose(file);
-    return 0;
+    wav_reader_close(&reader);
+    return *samples ? 0 : -1;
 }
 
 int get_user_input(char* buffer, int size) {
@@ -515,8 +1600,8 @@ int process_audio_file_config_array(AudioFileConfig configs[], int count) {
     int total_samples = 0;
     for (int i = 0; i < count; i++) {
         total_samples += configs[i].info.duration_samples;
-        printf("Arquivo %d: %s - %u amostras\n", 
-               i + 1, configs[i].filename, configs[i].info.duration_samples);
+        printf("Arquivo %d: %s - %llu amostras\n", 
+               i + 1, configs[i].filename, (unsigned long long)configs[i].info.duration_samples);
     }
     
     return total_samples;
@@ -1,6 +1,10 @@
 #ifndef WAV_READER_H
 #define WAV_READER_H
 
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -9,16 +13,111 @@ typedef struct {
     uint32_t sample_rate;
     uint16_t num_channels;
     uint16_t bits_per_sample;
-    uint32_t data_size;
-    uint32_t duration_samples;
+    uint64_t data_size;
+    uint64_t duration_samples;
+    uint16_t audio_format;  /* 1 = PCM, 3 = float; o subformato de WAVE_FORMAT_EXTENSIBLE já resolvido */
+    uint32_t channel_mask;  /* só em WAVE_FORMAT_EXTENSIBLE; 0 nos demais */
 } WAV_Info;
 
+/* Bits de dwChannelMask (WAVE_FORMAT_EXTENSIBLE). */
+#define WAV_SPEAKER_FRONT_LEFT 0x1
+#define WAV_SPEAKER_FRONT_RIGHT 0x2
+#define WAV_SPEAKER_FRONT_CENTER 0x4
+#define WAV_SPEAKER_LOW_FREQUENCY 0x8
+#define WAV_SPEAKER_BACK_LEFT 0x10
+#define WAV_SPEAKER_BACK_RIGHT 0x20
+#define WAV_SPEAKER_FRONT_LEFT_OF_CENTER 0x40
+#define WAV_SPEAKER_FRONT_RIGHT_OF_CENTER 0x80
+#define WAV_SPEAKER_BACK_CENTER 0x100
+#define WAV_SPEAKER_SIDE_LEFT 0x200
+#define WAV_SPEAKER_SIDE_RIGHT 0x400
+
+#define WAV_FORMAT_PCM 1
+#define WAV_FORMAT_IEEE_FLOAT 3
+#define WAV_FORMAT_EXTENSIBLE 0xFFFE
+
+typedef enum {
+    WAV_SAMPLE_UNSUPPORTED = 0,
+    WAV_SAMPLE_U8,
+    WAV_SAMPLE_S16,
+    WAV_SAMPLE_S24,
+    WAV_SAMPLE_S32,
+    WAV_SAMPLE_F32,
+    WAV_SAMPLE_FORMAT_COUNT
+} WavSampleFormat;
+
+#define WAV_READER_MAP 1
+
+/*
+ * Arquivo WAV aberto e analisado uma única vez. Guarda o formato e a posição
+ * do chunk "data"; wav_reader_read() lê quadros por posição e pode ser usada
+ * por várias threads ao mesmo tempo. Com WAV_READER_MAP, "data" aponta
+ * direto para os bytes mapeados em memória (ou é NULL se o mapeamento falhar).
+ */
+typedef struct {
+    WAV_Info info;
+    FILE* file;
+    int64_t data_offset;
+    uint16_t block_align;
+    WavSampleFormat format;
+    const uint8_t* data;
+    void* map_base;
+    size_t map_length;
+    void* map_handle;
+} WavReader;
+
 typedef struct {
     float volume;
     float pan;
     int enabled;
 } MixSettings;
 
+/* Compromisso qualidade/velocidade do reamostrador (número de coeficientes por fase). */
+typedef enum {
+    RESAMPLE_FAST = 0,
+    RESAMPLE_MEDIUM,
+    RESAMPLE_BEST
+} ResampleQuality;
+
+/* Layout de canais da saída. FOA é ambisônico de primeira ordem (AmbiX: W, Y, Z, X, SN3D). */
+typedef enum {
+    MIX_LAYOUT_STEREO = 0,
+    MIX_LAYOUT_MONO,
+    MIX_LAYOUT_5_1,
+    MIX_LAYOUT_7_1,
+    MIX_LAYOUT_FOA
+} MixChannelLayout;
+
+#define MIX_MAX_BUS_CHANNELS 8
+
+/*
+ * Opções de mix_wav_files_ex(); NULL equivale à saída estéreo em 16 bits com
+ * reamostragem RESAMPLE_MEDIUM.
+ */
+typedef struct {
+    WavSampleFormat sample_format;
+    ResampleQuality resample_quality;
+    MixChannelLayout channel_layout;
+} MixOptions;
+
+/*
+ * Um clipe da linha do tempo para mix_clips(): o arquivo toca a partir de
+ * start_seconds e dura length_seconds (0 = até o fim do arquivo). Clipes
+ * mudos, ou sem solo quando algum clipe tem solo, nem são abertos.
+ */
+typedef struct {
+    const char* filename;
+    float volume;
+    float pan;
+    double start_seconds;
+    double length_seconds;
+    int muted;
+    int solo;
+} MixClip;
+
+/* Mixagem sob demanda de uma lista de clipes, ver mix_stream_open(). */
+typedef struct MixStream MixStream;
+
 typedef struct {
     WAV_Info info;
     MixSettings settings;
@@ -32,8 +131,27 @@ void modify_mix_settings_by_reference(MixSettings* settings);
 int process_audio_file_config_array(AudioFileConfig configs[], int count);
 
 int mix_wav_files(const char* output_file, const char* input_files[], float volumes[], float pans[], int file_count);
+int mix_wav_files_ex(const char* output_file, const char* input_files[], float volumes[], float pans[], int file_count,
+                     const MixOptions* options);
+int mix_clips(const char* output_file, const MixClip clips[], int clip_count, const MixOptions* options);
+MixStream* mix_stream_open(const MixClip clips[], int clip_count, const MixOptions* options);
+void mix_stream_render(MixStream* stream, uint64_t first_frame, void* output, size_t frames);
+int mix_stream_set_gain(MixStream* stream, int clip_index, float volume, float pan);
+uint32_t mix_stream_sample_rate(const MixStream* stream);
+uint16_t mix_stream_channels(const MixStream* stream);
+uint64_t mix_stream_frames(const MixStream* stream);
+void mix_stream_close(MixStream* stream);
 int get_wav_info(const char* filename, WAV_Info* info);
 int read_wav_samples(const char* filename, int16_t** samples, size_t* sample_count, int max_samples);
+int wav_reader_open(WavReader* reader, const char* filename, int flags);
+size_t wav_reader_read(const WavReader* reader, uint64_t first_frame, void* buffer, size_t frames);
+void wav_reader_close(WavReader* reader);
+float wav_reader_sample(const WavReader* reader, size_t frame, uint16_t channel);
+WavSampleFormat wav_sample_format(const WAV_Info* info);
+uint16_t mix_layout_channels(MixChannelLayout layout);
+uint32_t mix_layout_mask(MixChannelLayout layout);
+int mix_channel_matrix(const WAV_Info* info, MixChannelLayout layout, float volume, float pan, float* matrix);
+uint16_t wav_sample_bytes(WavSampleFormat format);
 
 #ifdef __cplusplus
 }